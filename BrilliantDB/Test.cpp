@@ -1,7 +1,13 @@
 #include <iostream>
-#include <cassert>
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdlib>
 #include <filesystem>
+#include <sstream>
+#include <thread>
 #include "BrilliantDB.h"
+#include "ShardedDatabase.h"
 
 using namespace BrilliantDB;
 
@@ -25,53 +31,738 @@ struct TestV
 	primary_key_t i;
 	std::string s;
 	std::vector<char> blob;
+	std::vector<char> scratch; //not mapped to a column
 };
 
-int main()
+struct TestW
 {
-	try
+	int region;
+	std::string code;
+	double value;
+};
+
+struct TestX
+{
+	primary_key_t i;
+	Compressed<std::string> log;
+	Compressed<std::vector<char>, LzCodec, 16> payload;
+};
+
+struct Vec3
+{
+	float x, y, z;
+};
+
+struct Celsius
+{
+	double degrees;
+};
+
+namespace BrilliantDB
+{
+	template<>
+	struct ColumnTraits<Celsius>
+	{
+		using StorageType = double;
+		static double ToStorage(const Celsius& c) { return c.degrees; }
+		static Celsius FromStorage(double d) { return { d }; }
+	};
+}
+
+struct TestY
+{
+	primary_key_t i;
+	std::array<unsigned char, 32> hash;
+	Vec3 position;
+	Celsius temperature;
+};
+
+struct TestP
+{
+	primary_key_t i;
+	std::pmr::string name;
+	std::pmr::vector<char> data;
+};
+
+int iFailures = 0;
+
+//unlike assert it also runs in release builds, a failed check is reported and the run carries on
+#define CHECK(x) do { if (!(x)) { std::cout << __FILE__ << '(' << __LINE__ << "): check failed: " #x << std::endl; iFailures++; } } while (false)
+
+auto MakeTestUTable()
+{
+	return MakeTable<TestU>("TestU",
+		MakeColumn("j", &TestU::j, Constraint::primary_key, Constraint::auto_increment),
+		MakeColumn("teddy", &TestU::teddy),
+		MakeColumn("iTeddy", &TestU::iTeddy)
+	);
+}
+
+//ten rows, iTeddy 0 to 9 and teddy half of it
+template<class D>
+void FillTestU(const D& db)
+{
+	for (int i = 0; i < 10; i++) { (void)db.Insert(TestU{ 0, i * 0.5, i }); }
+}
+
+void TestMemory(const MemoryConfig& memory)
+{
+	//the pool hands out its size classes, switching back has to restore sqlite's own allocator
+	auto MallocSize = []() { void* p = sqlite3_malloc(20); auto n = sqlite3_msize(p); sqlite3_free(p); return n; };
+	auto iSystemSize = MallocSize();
+	ConfigureMemory(memory);
+	CHECK(MallocSize() == 32);
+	ConfigureMemory(MemoryConfig{});
+	CHECK(MallocSize() == iSystemSize);
+
+	ConfigureMemory(memory);
 	{
-		std::filesystem::create_directory("test");
-
-		auto DB = MakeDatabase(
-			"test//test.db",
-			MakeTable<TestU>("TestU",
-				MakeColumn("j", &TestU::j, Constraint::primary_key, Constraint::auto_increment),
-				MakeColumn("teddy", &TestU::teddy),
-				MakeColumn("iTeddy", &TestU::iTeddy)
-				),
-			MakeTable<TestV>("TestV",
-				MakeColumn("i", &TestV::i, Constraint::primary_key, Constraint::auto_increment),
-				MakeColumn("s", &TestV::s),
-				MakeColumn("b", &TestV::blob)
-				),
-			MakeTable<TestT>("TestT",
-				MakeColumn("i", &TestT::i, Constraint::primary_key, Constraint::auto_increment),
-				MakeColumn("d", &TestT::d),
-				MakeColumn("v", &TestT::v),
-				MakeColumn("s", &TestT::s),
-				MakeForeignKey(&TestT::d, &TestU::j),
-				MakeForeignKey(&TestT::v, &TestV::i)
-				)
+		Connection open(":memory:");
+		bool bRefused = false;
+		try { ConfigureMemory(memory); }
+		catch (const std::system_error& e) { bRefused = e.code().value() == SQLITE_MISUSE; }
+		CHECK(bRefused);
+	}
+
+	auto MemDB = MakeDatabase(":memory:", MakeTestUTable());
+	FillTestU(MemDB);
+	CHECK(GetMemoryStats().iUsed > 0 && GetMemoryStats().iSoftHeapLimit == memory.iSoftHeapLimit);
+	CHECK(MemDB.GetMemoryStats().iCacheUsed > 0);
+}
+
+void TestCrud()
+{
+	auto DB = MakeDatabase(
+		"test//test.db",
+		MakeTable<TestU>("TestU",
+			MakeColumn("j", &TestU::j, Constraint::primary_key, Constraint::auto_increment),
+			MakeColumn("teddy", &TestU::teddy),
+			MakeColumn("iTeddy", &TestU::iTeddy)
+			),
+		MakeTable<TestV>("TestV",
+			MakeColumn("i", &TestV::i, Constraint::primary_key, Constraint::auto_increment),
+			MakeColumn("s", &TestV::s),
+			MakeColumn("b", &TestV::blob)
+			),
+		MakeFtsTable<TestV>("TestV_fts", &TestV::s),
+		MakeTable<TestT>("TestT",
+			MakeColumn("i", &TestT::i, Constraint::primary_key, Constraint::auto_increment),
+			MakeColumn("d", &TestT::d),
+			MakeColumn("v", &TestT::v),
+			MakeColumn("s", &TestT::s),
+			MakeForeignKey(&TestT::d, &TestU::j),
+			MakeForeignKey(&TestT::v, &TestV::i)
+			)
+	);
+
+	sqlite3_exec(DB.connection.pDb, "PRAGMA user_version = 7;", nullptr, nullptr, nullptr);
+	DB.ReconcileSchema();
+	int iVersion = 0;
+	sqlite3_exec(DB.connection.pDb, "PRAGMA user_version;", [](void* data, int, char** argv, char**) -> int { *static_cast<int*>(data) = std::atoi(argv[0]); return 0; }, &iVersion, nullptr);
+	CHECK(iVersion == 7);
+
+	TestV tv{ 0,"",{'a','b','c'} };
+	tv.i = DB.Insert(tv);
+
+	TestT tt{ 0,0,0,"Test" };
+	tt.i = DB.Insert(tt);
+
+	tt.d = tv.i;
+	auto ttv = DB.Get<TestV>(tt.d);
+
+	CHECK(ttv);
+	CHECK(ttv && ttv->i == tt.d);
+
+	DB.SetCacheCapacity<TestV>(16);
+	(void)DB.Get<TestV>(tv.i);
+	auto cached = DB.Get<TestV>(tv.i);
+	CHECK(cached && cached->blob == tv.blob);
+	CHECK(DB.GetCacheStats<TestV>().iHits == 1);
+	if (cached) { DB.Remove(*cached); }
+	CHECK(!DB.Get<TestV>(tv.i));
+
+	TestV big{ 0, "big", {} };
+	big.i = DB.Insert(big, ZeroBlob<TestV>{ &TestV::blob, 1000 });
+	std::string sPayload(1000, 'x');
+	std::istringstream is(sPayload);
+	CHECK(DB.OpenBlob(big.i, &TestV::blob, true).WriteFrom(is, 64) == 1000);
+	std::ostringstream os;
+	DB.OpenBlob(big.i, &TestV::blob).ReadTo(os, 64);
+	CHECK(os.str() == sPayload);
+	bool bThrew = false;
+	try { DB.OpenBlob(big.i, &TestV::blob).ReadTo(os, 0); }
+	catch (const std::runtime_error&) { bThrew = true; }
+	CHECK(bThrew);
+	bThrew = false;
+	try { (void)DB.OpenBlob(big.i, &TestV::blob, true).WriteFrom(is, -1); }
+	catch (const std::runtime_error&) { bThrew = true; }
+	CHECK(bThrew);
+	bThrew = false;
+	const auto iRows = DB.GetAll<TestV>().size();
+	try { (void)DB.Insert(big, ZeroBlob<TestV>{ &TestV::scratch, 10 }); }
+	catch (const std::runtime_error&) { bThrew = true; }
+	CHECK(bThrew);
+	CHECK(DB.GetAll<TestV>().size() == iRows);
+
+	(void)DB.Insert(TestV{ 0, "brilliant search, brilliant results", {} });
+	(void)DB.Insert(TestV{ 0, "a brilliant idea", {} });
+	auto match = Match(&TestV::s, "brilliant");
+	auto vFound = DB.GetAll<TestV>(Where(match), OrderByRank(match));
+	CHECK(vFound.size() == 2 && vFound.front().s == "brilliant search, brilliant results");
+	CHECK(DB.GetAll<TestV>(OrderByRank(match)).size() == 2);
+	CHECK(DB.GetAll<TestV>(Where(C(&TestV::s) != std::string("a brilliant idea")), OrderByRank(match)).size() == 1);
+	DB.RemoveAll<TestV>(Where(match));
+	CHECK(DB.GetAll<TestV>(Where(Match(&TestV::s, "idea"))).empty());
+}
+
+void TestNaturalKeys()
+{
+	std::vector<TableOption> vKeyOptions{ TableOption::without_rowid, TableOption::strict };
+	if (sqlite3_libversion_number() < iStrictMinVersion)
+	{
+		bool bRejected = false;
+		try { (void)MakeDatabase(":memory:", MakeTable<TestW>("TestW", vKeyOptions, MakeColumn("region", &TestW::region, Constraint::primary_key))); }
+		catch (const std::runtime_error&) { bRejected = true; }
+		CHECK(bRejected);
+		vKeyOptions.pop_back();
+	}
+	auto KeyDB = MakeDatabase(":memory:",
+		MakeTable<TestW>("TestW", vKeyOptions,
+			MakeColumn("region", &TestW::region, Constraint::primary_key),
+			MakeColumn("code", &TestW::code, Constraint::primary_key),
+			MakeColumn("value", &TestW::value)
+			)
+	);
+	(void)KeyDB.Insert(TestW{ 1, "a", 0.5 });
+	(void)KeyDB.Insert(TestW{ 1, "b", 1.5 });
+	KeyDB.Update(TestW{ 1, "b", 2.5 });
+	auto tw = KeyDB.Get<TestW>(1, "b");
+	CHECK(tw && tw->value == 2.5);
+	if (tw) { KeyDB.Remove(*tw); }
+	CHECK(!KeyDB.Get<TestW>(1, "b") && KeyDB.Get<TestW>(1, "a"));
+}
+
+void TestCompression()
+{
+	auto LogDB = MakeDatabase(":memory:",
+		MakeTable<TestX>("TestX",
+			MakeColumn("i", &TestX::i, Constraint::primary_key, Constraint::auto_increment),
+			MakeColumn("log", &TestX::log),
+			MakeColumn("payload", &TestX::payload)
+			)
+	);
+	TestX tx;
+	for (int i = 0; i < 200; i++) { tx.log.value += "{\"level\":\"info\",\"line\":" + std::to_string(i) + "}\n"; }
+	tx.payload.value = { 'a', 'b' };
+	tx.i = LogDB.Insert(tx);
+	auto txLoaded = LogDB.Get<TestX>(tx.i);
+	CHECK(txLoaded && txLoaded->log.value == tx.log.value && txLoaded->payload.value == tx.payload.value);
+
+	//the match table is reused between calls, a second input must not pick up matches from the first
+	std::string sOther(300, 'q');
+	auto vPacked = LzCodec::Compress(sOther.data(), sOther.size());
+	auto vUnpacked = LzCodec::Decompress(vPacked.data(), vPacked.size(), sOther.size());
+	CHECK(std::string(vUnpacked.begin(), vUnpacked.end()) == sOther);
+	bool bThrown = false;
+	try { (void)LzCodec::Decompress(vPacked.data(), vPacked.size(), sOther.size() - 1); }
+	catch (const std::runtime_error&) { bThrown = true; }
+	CHECK(bThrown);
+
+	//a corrupt stored size is reported like any other corruption instead of being allocated up front
+	std::vector<char> vStored{ 1, 0, 0, 0, 0, 0, 0, 0, 0x10 };
+	vStored.insert(vStored.end(), vPacked.begin(), vPacked.end());
+	Compressed<std::string> corrupt;
+	bThrown = false;
+	try { corrupt.Decode(vStored.data(), vStored.size()); }
+	catch (const std::runtime_error& e) { bThrown = std::string(e.what()) == "corrupt compressed value"; }
+	CHECK(bThrown);
+}
+
+void TestRawBlobs()
+{
+	auto MakeTestYTable = []() {
+		return MakeTable<TestY>("TestY",
+			MakeColumn("i", &TestY::i, Constraint::primary_key, Constraint::auto_increment),
+			MakeColumn("hash", &TestY::hash),
+			MakeColumn("position", &TestY::position),
+			MakeColumn("temperature", &TestY::temperature)
 		);
+	};
+	auto PodDB = MakeDatabase(":memory:", MakeTestYTable());
+	TestY ty{ 0, {}, { 1.f, 2.f, 3.f }, { 21.5 } };
+	ty.hash.fill(0xab);
+	ty.i = PodDB.Insert(ty);
+	auto tyLoaded = PodDB.Get<TestY>(ty.i);
+	CHECK(tyLoaded && tyLoaded->hash == ty.hash && tyLoaded->position.z == 3.f && tyLoaded->temperature.degrees == 21.5);
+	CHECK(PodDB.GetTableInfo<TestY>()[3].sColType == "REAL");
+	{
+		auto transaction = PodDB.BeginTransaction();
+		for (int i = 0; i < 500; i++) { (void)PodDB.Insert(TestY{ 0, {}, { float(i), 0.f, 0.f }, { 0.0 } }); }
+		transaction.Commit();
+	}
+	{
+		std::size_t iRows = 0;
+		auto prefetch = PodDB.Prefetch<TestY>(8);
+		while (auto row = prefetch.Next()) { iRows++; }
+		CHECK(iRows == 501);
+		auto partial = PodDB.Prefetch<TestY>(4, Where(C(&TestY::i) > primary_key_t{ 1 }));
+		CHECK(partial.Next() && partial.Next());
+		partial.Cancel();
+		CHECK(!partial.Next());
+	}
+	{
+		CancellationToken token;
+		auto guard = PodDB.LimitQueries({ std::chrono::milliseconds(0), token, 1 });
+		token.Cancel();
+		auto cancelled = PodDB.Prefetch<TestY>(8);
+		bool bCancelled = false;
+		try { while (cancelled.Next()); }
+		catch (const QueryCancelled&) { bCancelled = true; }
+		CHECK(bCancelled);
+	}
+	PodDB.RemoveAll<TestY>(Where(C(&TestY::i) > primary_key_t{ 1 }));
+
+	sqlite3_exec(PodDB.connection.pDb, "UPDATE TestY SET position = x'0000';", nullptr, nullptr, nullptr);
+	bool bThrown = false;
+	try { (void)PodDB.GetAll<TestY>(); }
+	catch (const std::runtime_error& e) { bThrown = std::string(e.what()).starts_with("raw blob"); }
+	CHECK(bThrown);
+	PodDB.Update(ty);
+
+	std::stringstream ss;
+	CHECK(PodDB.Export<TestY>(ss) == 1);
+	auto CopyDB = MakeDatabase(":memory:", MakeTestYTable());
+	CHECK(CopyDB.Import<TestY>(ss) == 1);
+	auto tyCopy = CopyDB.Get<TestY>(ty.i);
+	CHECK(tyCopy && tyCopy->hash == ty.hash && tyCopy->temperature.degrees == 21.5);
+}
+
+void TestPmrAndTransfer()
+{
+	auto MakeTestPTable = []() {
+		return MakeTable<TestP>("TestP",
+			MakeColumn("i", &TestP::i, Constraint::primary_key, Constraint::auto_increment),
+			MakeColumn("name", &TestP::name),
+			MakeColumn("data", &TestP::data)
+		);
+	};
+	auto PmrDB = MakeDatabase(":memory:", MakeTestPTable());
+	(void)PmrDB.Insert(TestP{ 0, "a rather long name that won't fit the small string buffer", { 'x', 'y' } });
+	(void)PmrDB.Insert(TestP{ 0, "b", {} });
+	{
+		std::pmr::monotonic_buffer_resource arena;
+		auto vRows = PmrDB.GetAll<TestP>(&arena);
+		CHECK(vRows.size() == 2 && vRows.get_allocator().resource() == &arena);
+		CHECK(vRows.size() == 2 && vRows[0].name.get_allocator().resource() == &arena && vRows[0].data.size() == 2 && vRows[1].name == "b");
+		std::pmr::memory_resource* pResource = &arena;
+		CHECK(PmrDB.GetAll<TestP>(pResource, Where(C(&TestP::name) == std::pmr::string("b"))).size() == 1);
+	}
+	CHECK(PmrDB.GetAll<TestP>(Where(C(&TestP::name).Like("A RATHER%"))).size() == 1);
+	CHECK(PmrDB.GetAll<TestP>(Where(C(&TestP::name).Glob("A*"))).empty());
+
+	(void)PmrDB.Insert(TestP{ 0, "quote \" comma , newline \n", { '\0', '\xff' } });
+	for (auto format : { TransferFormat::csv, TransferFormat::binary })
+	{
+		std::stringstream ss;
+		CHECK(PmrDB.Export<TestP>(ss, format) == 3);
+		auto CopyDB = MakeDatabase(":memory:", MakeTestPTable());
+		CHECK(CopyDB.Import<TestP>(ss, format) == 3);
+		auto vCopy = CopyDB.GetAll<TestP>();
+		CHECK(vCopy.size() == 3 && vCopy[2].name == "quote \" comma , newline \n" && vCopy[2].data.size() == 2 && vCopy[2].data[1] == '\xff' && vCopy[1].data.empty());
+	}
+}
+
+void TestFilters()
+{
+	auto FilterDB = MakeDatabase(":memory:", MakeTestUTable());
+	FillTestU(FilterDB);
+	std::vector<int> vWanted{ 1, 3, 5, 7 };
+	CHECK(FilterDB.GetAll<TestU>(Where(C(&TestU::iTeddy).In(vWanted))).size() == 4);
+	CHECK(FilterDB.GetAll<TestU>(Where(!C(&TestU::iTeddy).In({ 1, 2 }))).size() == 8);
+	CHECK(FilterDB.GetAll<TestU>(Where(C(&TestU::teddy).Between(1.0, 2.0))).size() == 3);
+	CHECK(FilterDB.GetAll<TestU>(Where(!C(&TestU::iTeddy).IsNull())).size() == 10);
+
+	//negation returns a copy, a condition kept in a variable can be used both ways
+	auto param = C(&TestU::iTeddy) == Param<0>;
+	auto call = Call("abs", &TestU::iTeddy);
+	CHECK((!param).bNot && !param.bNot && (!call).bNot && !call.bNot);
+
+	//(iTeddy < 2 OR iTeddy > 7) AND NOT (teddy = 0 OR iTeddy IN (9)) leaves 1 and 8
+	auto vGrouped = FilterDB.GetAll<TestU>(Where((C(&TestU::iTeddy) < 2 || C(&TestU::iTeddy) > 7) && !(C(&TestU::teddy) == 0.0 || C(&TestU::iTeddy).In({ 9 }))));
+	CHECK(vGrouped.size() == 2 && vGrouped[0].iTeddy == 1 && vGrouped[1].iTeddy == 8);
+	auto inQuery = FilterDB.MakeQuery(Select<TestU>(Where(C(&TestU::iTeddy).In({ 2, 4, 6 }) && C(&TestU::iTeddy) > Param<0>)));
+	CHECK(inQuery.Run(3).size() == 2);
+}
 
-		TestV tv{ 0,"",{'a','b','c'} };
-		tv.i = DB.Insert(tv);
+void TestResultCache()
+{
+	auto CacheDB = MakeDatabase(":memory:", MakeTestUTable());
+	FillTestU(CacheDB);
+	CacheDB.EnableResultCache();
+	CHECK(CacheDB.GetAll<TestU>(Where(C(&TestU::iTeddy) > 5)).size() == 4);
+	CHECK(CacheDB.GetAll<TestU>(Where(C(&TestU::iTeddy) > 5)).size() == 4);
+	CHECK(CacheDB.GetAll<TestU>(Where(C(&TestU::iTeddy) > 6)).size() == 3);
+	CHECK(CacheDB.GetResultCacheStats().iHits == 1 && CacheDB.GetResultCacheStats().iMisses == 2);
+	(void)CacheDB.Insert(TestU{ 0, 10.0, 10 });
+	CHECK(CacheDB.GetAll<TestU>(Where(C(&TestU::iTeddy) > 5)).size() == 5);
+	auto inQuery = CacheDB.MakeQuery(Select<TestU>(Where(C(&TestU::iTeddy).In({ 2, 4, 6 }) && C(&TestU::iTeddy) > Param<0>)));
+	CHECK(inQuery.Run(3).size() == 2 && inQuery.Run(3).size() == 2 && CacheDB.GetResultCacheStats().iHits == 2);
+	CacheDB.DisableResultCache();
+}
+
+void TestBusy()
+{
+	auto WriterA = MakeDatabase("test//busy.db", MakeTestUTable());
+	auto WriterB = MakeDatabase("test//busy.db", MakeTestUTable());
+	WriterB.SetBusyPolicy({ BusyMode::backoff, std::chrono::milliseconds(50) });
+	{
+		auto transaction = WriterA.BeginTransaction(TransactionMode::immediate);
+		(void)WriterA.Insert(TestU{ 0, 1.0, 1 });
+		bool bBusy = false;
+		try { (void)WriterB.Insert(TestU{ 0, 2.0, 2 }); }
+		catch (const std::system_error& e) { bBusy = e.code().value() == SQLITE_BUSY; }
+		CHECK(bBusy);
+		transaction.Commit();
+	}
+	(void)WriterB.Insert(TestU{ 0, 2.0, 2 });
+	auto busy = WriterB.GetBusyStats();
+	CHECK(busy.iBusyEvents == 1 && busy.iTimeouts == 1 && busy.iRetries > 0 && busy.waited.count() > 0);
+	CHECK(WriterA.GetAll<TestU>().size() == 2);
+}
+
+void TestInterrupts()
+{
+	auto SlowDB = MakeDatabase(":memory:", MakeTestUTable());
+	FillTestU(SlowDB);
+	SlowDB.RegisterFunction("slow", [](int i) { std::this_thread::sleep_for(std::chrono::milliseconds(2)); return i; });
+	{
+		auto guard = SlowDB.LimitQueries({ std::chrono::milliseconds(5), {}, 10 });
+		bool bTimeout = false;
+		try { (void)SlowDB.GetAll<TestU>(Where(Call("slow", &TestU::iTeddy) > 0)); }
+		catch (const QueryTimeout&) { bTimeout = true; }
+		CHECK(bTimeout && guard.Reason() == InterruptReason::timeout);
+		//the deadline starts over for every query, one that fits in it runs although the guard outlived the first
+		CHECK(!SlowDB.GetAll<TestU>().empty() && guard.Reason() == InterruptReason::none);
+	}
+	{
+		CancellationToken token;
+		auto guard = SlowDB.LimitQueries({ std::chrono::milliseconds(0), token, 1 });
+		token.Cancel();
+		bool bCancelled = false;
+		try { SlowDB.UpdateAll<TestU>(Set(C(&TestU::teddy) == 0.25)); }
+		catch (const QueryCancelled& e) { bCancelled = e.code().value() == SQLITE_INTERRUPT; }
+		CHECK(bCancelled);
+	}
+	CHECK(SlowDB.GetAll<TestU>(Where(C(&TestU::teddy) == 0.25)).empty() && SlowDB.GetAll<TestU>(Where(Call("slow", &TestU::iTeddy) > 0)).size() == 9);
+}
+
+void TestCheckpointer()
+{
+	auto WalDB = MakeDatabase("test//wal.db", MakeTestUTable());
+	WalDB.StartCheckpointer({ CheckpointMode::passive, std::chrono::milliseconds(0), 1 });
+	(void)WalDB.Insert(TestU{ 0, 1.0, 1 });
+	for (int i = 0; i < 200 && WalDB.GetCheckpointStats().iRuns == 0; i++) { std::this_thread::sleep_for(std::chrono::milliseconds(5)); }
+	CHECK(WalDB.GetCheckpointStats().iRuns > 0 && WalDB.GetCheckpointStats().last.iLogFrames > 0);
+	auto truncated = WalDB.Checkpoint(CheckpointMode::truncate);
+	CHECK(truncated.bComplete && truncated.iLogFrames == 0 && std::filesystem::file_size("test//wal.db-wal") == 0);
+	WalDB.StopCheckpointer();
+
+	auto MemDB = MakeDatabase(":memory:", MakeTestUTable());
+	bool bNoWal = false;
+	try { MemDB.StartCheckpointer(); }
+	catch (const std::runtime_error&) { bNoWal = true; }
+	CHECK(bNoWal);
+}
+
+void TestMaintenance()
+{
+	auto MaintDB = MakeDatabase("test//maint.db", DatabaseOptions{ AutoVacuum::incremental }, MakeTestUTable());
+	CHECK(MaintDB.GetSpaceStats().autoVacuum == AutoVacuum::incremental);
+	MaintDB.SetBusyPolicy({ BusyMode::timeout, std::chrono::milliseconds(1000) });
+	{
+		auto transaction = MaintDB.BeginTransaction();
+		for (int i = 0; i < 5000; i++) { (void)MaintDB.Insert(TestU{ 0, i * 1.5, i }); }
+		transaction.Commit();
+	}
+	MaintDB.RemoveAll<TestU>();
+	auto space = MaintDB.GetSpaceStats();
+	CHECK(space.autoVacuum == AutoVacuum::incremental && space.iFreelistCount > 10);
+	CHECK(MaintDB.IncrementalVacuum(10) == 10 && MaintDB.GetSpaceStats().iFreelistCount == space.iFreelistCount - 10);
+	MaintDB.StartMaintenance({ std::chrono::milliseconds(5), 4, 2, 1, std::chrono::milliseconds(1) });
+	for (int i = 0; i < 400 && MaintDB.GetMaintenanceStats().iPagesFreed < space.iFreelistCount - 10; i++) { std::this_thread::sleep_for(std::chrono::milliseconds(5)); }
+	auto maintenance = MaintDB.GetMaintenanceStats();
+	MaintDB.StopMaintenance();
+	CHECK(MaintDB.GetSpaceStats().iFreelistCount == 0 && maintenance.iPagesFreed == space.iFreelistCount - 10 && maintenance.iOptimizeRuns > 0 && maintenance.iErrors == 0);
+	MaintDB.Analyze();
+	MaintDB.Optimize();
+
+	//a database that already has tables is converted with a VACUUM
+	auto ConvertDB = MakeDatabase(":memory:", MakeTestUTable());
+	FillTestU(ConvertDB);
+	ConvertDB.SetAutoVacuum(AutoVacuum::full);
+	CHECK(ConvertDB.GetSpaceStats().autoVacuum == AutoVacuum::full && ConvertDB.GetAll<TestU>().size() == 10);
+}
 
-		TestT tt{ 0,0,0,"Test" };
-		tt.i = DB.Insert(tt);
+void TestSessions()
+{
+	auto NodeA = MakeDatabase("test//node_a.db", MakeTestUTable());
+	auto NodeB = MakeDatabase("test//node_b.db", MakeTestUTable());
+	{
+		auto session = NodeA.CreateSession<TestU>();
+		(void)NodeA.Insert(TestU{ 0, 4.0, 40 });
+		(void)NodeA.Insert(TestU{ 0, 5.0, 50 });
+		auto changes = session.GetChangeset();
+		changes.Save("test//node_a.changeset");
+		NodeB.ApplyChangeset(Changeset::Load("test//node_a.changeset"), ConflictPolicy::replace);
+	}
+	CHECK(NodeB.GetAll<TestU>(Where(C(&TestU::iTeddy) >= 40)).size() == 2);
+
+	//the rows are already there, so every insert conflicts and abort rolls the whole changeset back
+	int iCode = 0;
+	try { NodeB.ApplyChangeset(Changeset::Load("test//node_a.changeset"), ConflictPolicy::abort); }
+	catch (const std::system_error& e) { iCode = e.code().value(); }
+	CHECK(iCode == SQLITE_ABORT && NodeB.GetAll<TestU>(Where(C(&TestU::iTeddy) >= 40)).size() == 2);
+}
+
+void TestSharding()
+{
+	auto Sharded = MakeShardedDatabase({ "test//shard_0.db", "test//shard_1.db" }, MakeTestUTable());
+	std::vector<primary_key_t> vKeys;
+	for (int i = 0; i < 4; i++) { vKeys.push_back(Sharded.Insert(TestU{ 0, 0.0, 100 + i })); }
+	CHECK(Sharded.GetAll<TestU>().size() == 4);
+	auto tuSharded = Sharded.Get<TestU>(vKeys[3]);
+	CHECK(tuSharded && tuSharded->iTeddy == 103 && tuSharded->j._t == vKeys[3]._t);
+	if (tuSharded) { Sharded.Remove(*tuSharded); }
+	CHECK(!Sharded.Get<TestU>(vKeys[3]) && Sharded.Get<TestU>(vKeys[2]));
+	auto vCounts = Sharded.FanOut([](const auto& shard, std::size_t) { return shard.template GetAll<TestU>().size(); });
+	CHECK(vCounts.size() == 2 && vCounts[0] + vCounts[1] == 3);
 
-		tt.d = tv.i;
-		auto ttv = DB.Get<TestV>(tt.d);
+	//a negative key can't name a shard, one that was never inserted still has the default of -1
+	CHECK(!Sharded.Get<TestU>(primary_key_t{ -1 }));
+	bool bRejected = false;
+	try { Sharded.Remove(TestU{}); }
+	catch (const std::runtime_error&) { bRejected = true; }
+	CHECK(bRejected);
 
-		assert(ttv);
-		assert(ttv->i == tt.d);
+	std::vector<std::vector<sqlite3_int64>> vThreadKeys(4);
+	std::vector<std::thread> vWriters;
+	for (std::size_t t = 0; t < vThreadKeys.size(); t++)
+	{
+		vWriters.emplace_back([&Sharded, &vThreadKeys, t]() {
+			for (int i = 0; i < 25; i++) { vThreadKeys[t].push_back(Sharded.Insert(TestU{ 0, 0.0, 1000 })._t); }
+			});
+	}
+	for (auto& writer : vWriters) { writer.join(); }
+	std::vector<sqlite3_int64> vAll;
+	for (auto& v : vThreadKeys) { vAll.insert(vAll.end(), v.begin(), v.end()); }
+	std::sort(vAll.begin(), vAll.end());
+	CHECK(std::unique(vAll.begin(), vAll.end()) == vAll.end() && Sharded.GetAll<TestU>(Where(C(&TestU::iTeddy) == 1000)).size() == 100);
+}
+
+void TestPrefetch()
+{
+	auto PrefetchDB = MakeDatabase(":memory:", MakeTestUTable());
+	{
+		auto transaction = PrefetchDB.BeginTransaction();
+		for (int i = 0; i < 500; i++) { (void)PrefetchDB.Insert(TestU{ 0, i * 0.5, i }); }
+		transaction.Commit();
+	}
+
+	//cancelling a prefetch part way must leave the other statements on the connection running
+	auto query = PrefetchDB.MakeQuery(Select<TestU>(Where(C(&TestU::iTeddy) < Param<0>)));
+	std::size_t iOuter = 0;
+	{
+		auto cursor = query.Stream(5);
+		while (cursor.Next())
+		{
+			auto inner = PrefetchDB.Prefetch<TestU>(4);
+			CHECK(inner.Next());
+			iOuter++;
+		}
+	}
+	CHECK(iOuter == 5);
+
+	//the caller's queries share the guard with the producer while the prefetch runs
+	{
+		auto guard = PrefetchDB.LimitQueries({ std::chrono::milliseconds(10000), {}, 1 });
+		auto prefetch = PrefetchDB.Prefetch<TestU>(2);
+		std::size_t iRows = 0;
+		while (prefetch.Next())
+		{
+			iRows++;
+			CHECK(PrefetchDB.Get<TestU>(primary_key_t{ 1 }) && PrefetchDB.GetAll<TestU>(Where(C(&TestU::iTeddy) < 3)).size() == 3);
+		}
+		CHECK(iRows == 500 && guard.Reason() == InterruptReason::none);
+	}
+}
+
+void TestBatches()
+{
+	auto BatchDB = MakeDatabase(":memory:", MakeTestUTable());
+	std::vector<TestU> vBatch;
+	for (int i = 0; i < 600; i++)
+	{
+		TestU u{ 0, 0.0, i };
+		u.j = BatchDB.Insert(u);
+		u.teddy = i * 0.5;
+		vBatch.push_back(u);
+	}
+	CHECK(BatchDB.UpdateMany<TestU>(vBatch) == 600);
+	auto tuUpdated = BatchDB.Get<TestU>(vBatch[10].j);
+	CHECK(tuUpdated && tuUpdated->teddy == 5.0);
+	std::vector<primary_key_t> vRemove;
+	for (int i = 0; i < 300; i++) { vRemove.push_back(vBatch[i].j); }
+	CHECK(BatchDB.RemoveMany<TestU>(vRemove) == 300);
+	CHECK(BatchDB.RemoveMany<TestU>(std::vector<TestU>(vBatch.begin() + 300, vBatch.end() - 1)) == 299);
+	CHECK(BatchDB.GetAll<TestU>().size() == 1);
+}
+
+void TestSnapshots()
+{
+	auto MemDB = MakeDatabase(":memory:", MakeTestUTable());
+	TestU tu{ 0, 1.5, 3 };
+	tu.j = MemDB.Insert(tu);
+	MemDB.SaveSnapshot("test//snapshot.db");
+
+	auto LoadedDB = MakeDatabase("file:loaded?mode=memory&cache=shared", MakeTestUTable());
+	int iSteps = 0;
+	LoadedDB.LoadSnapshot("test//snapshot.db", { 1, 0, [&iSteps](int, int) { iSteps++; } });
+	auto tuLoaded = LoadedDB.Get<TestU>(tu.j);
+	CHECK(iSteps > 0);
+	CHECK(tuLoaded && tuLoaded->iTeddy == 3);
+}
+
+void TestQueries()
+{
+	auto QueryDB = MakeDatabase(":memory:", MakeTestUTable());
+	(void)QueryDB.Insert(TestU{ 0, 1.5, 3 });
+	(void)QueryDB.Insert(TestU{ 0, 2.5, 4 });
+	auto query = QueryDB.MakeQuery(Select<TestU>(Where(C(&TestU::iTeddy) >= Param<0> && C(&TestU::teddy) < Param<1>)));
+	CHECK(query.Run(3, 2.0).size() == 1);
+	CHECK(query.Run(3, 3.0).size() == 2);
+	{
+		auto cursor = query.Stream(4, 3.0);
+		CHECK(cursor.Next() && !cursor.Next());
+	}
+	{
+		auto prefetch = query.Prefetch(1, 3, 3.0);
+		CHECK(prefetch.Next() && prefetch.Next() && !prefetch.Next() && !prefetch.Next());
+	}
+	auto update = QueryDB.MakeQuery(Update<TestU>(Set(C(&TestU::teddy) == 0.0), Where(C(&TestU::iTeddy) == Param<0>)));
+	CHECK(update.Run(4) == 1);
+}
+
+void TestChangeFeed()
+{
+	auto FeedDB = MakeDatabase(":memory:", MakeTestUTable());
+	std::vector<ChangeEvent<TestU>> vEvents;
+	auto iSubscription = FeedDB.Subscribe<TestU>([&vEvents](const ChangeEvent<TestU>& e) { vEvents.push_back(e); });
+	auto tuNew = TestU{ 0, 9.0, 9 };
+	tuNew.j = FeedDB.Insert(tuNew);
+	CHECK(vEvents.size() == 1 && vEvents[0].type == ChangeType::insert && vEvents[0].key._t == tuNew.j._t);
+	{
+		auto transaction = FeedDB.BeginTransaction();
+		FeedDB.Remove(tuNew);
+		CHECK(vEvents.size() == 1);
+	}
+	CHECK(vEvents.size() == 1 && FeedDB.Get<TestU>(tuNew.j));
+	{
+		auto transaction = FeedDB.BeginTransaction();
+		FeedDB.Remove(tuNew);
+		transaction.Commit();
+	}
+	CHECK(vEvents.size() == 2 && vEvents[1].type == ChangeType::remove);
+
+	//a throwing callback gets its exception back to the caller without costing the other events or later deliveries
+	int iCalls = 0;
+	auto iThrowing = FeedDB.Subscribe<TestU>([&iCalls](const ChangeEvent<TestU>&) { if (iCalls++ == 0) { throw std::runtime_error("subscriber failed"); } });
+	bool bThrown = false;
+	try
+	{
+		auto transaction = FeedDB.BeginTransaction();
+		for (int i = 0; i < 3; i++) { (void)FeedDB.Insert(TestU{ 0, 1.0, i }); }
+		transaction.Commit();
+	}
+	catch (const std::runtime_error&) { bThrown = true; }
+	CHECK(bThrown && iCalls == 3 && vEvents.size() == 5 && FeedDB.GetAll<TestU>().size() == 3);
+	(void)FeedDB.Insert(TestU{ 0, 1.0, 3 });
+	CHECK(iCalls == 4 && vEvents.size() == 6);
+	FeedDB.Unsubscribe(iThrowing);
+	FeedDB.Unsubscribe(iSubscription);
+}
+
+void TestFunctions()
+{
+	auto FunctionDB = MakeDatabase(":memory:", MakeTestUTable());
+	(void)FunctionDB.Insert(TestU{ 0, 1.5, 3 });
+	(void)FunctionDB.Insert(TestU{ 0, 2.5, 4 });
+	FunctionDB.RegisterFunction("near", [](double d, double target) { return std::abs(d - target) < 0.25; });
+	CHECK(FunctionDB.GetAll<TestU>(Where(Call("near", &TestU::teddy, 1.4))).size() == 1);
+	FunctionDB.RegisterFunction("scaled", [](int i, int k) { return i * k; });
+	CHECK(FunctionDB.GetAll<TestU>(Where(Call("scaled", &TestU::iTeddy, 10) > 35)).size() == 1);
+	FunctionDB.RegisterFunction("odd", [](int i) { if (i) { throw i; } return i; });
+	bool bThrown = false;
+	try { (void)FunctionDB.GetAll<TestU>(Where(Call("odd", &TestU::iTeddy) == 0)); }
+	catch (const std::system_error&) { bThrown = true; }
+	CHECK(bThrown);
+}
+
+//an exception escaping a test counts as a failure, the remaining tests still run
+template<class F>
+void Run(const char* sName, F&& f)
+{
+	try
+	{
+		f();
 	}
 	catch (std::system_error& e)
 	{
-		std::cout << e.what() << '\n'
+		std::cout << sName << ": " << e.what() << '\n'
 			<< e.code() << std::endl;
+		iFailures++;
 	}
+	catch (std::exception& e)
+	{
+		std::cout << sName << ": " << e.what() << std::endl;
+		iFailures++;
+	}
+}
+
+int main()
+{
+	std::filesystem::remove_all("test");
+	std::filesystem::create_directory("test");
 
+	MemoryConfig memory;
+	memory.allocator = AllocatorKind::pool;
+	memory.iPageCacheSlots = 64;
+	memory.iSoftHeapLimit = 64 * 1024 * 1024;
+	Run("memory", [&memory]() { TestMemory(memory); });
+
+	Run("crud", TestCrud);
+	Run("natural keys", TestNaturalKeys);
+	Run("compression", TestCompression);
+	Run("raw blobs", TestRawBlobs);
+	Run("prefetch", TestPrefetch);
+	Run("pmr and transfer", TestPmrAndTransfer);
+	Run("filters", TestFilters);
+	Run("result cache", TestResultCache);
+	Run("busy", TestBusy);
+	Run("interrupts", TestInterrupts);
+	Run("checkpointer", TestCheckpointer);
+	Run("maintenance", TestMaintenance);
+	Run("sessions", TestSessions);
+	Run("sharding", TestSharding);
+	Run("batches", TestBatches);
+	Run("snapshots", TestSnapshots);
+	Run("queries", TestQueries);
+	Run("change feed", TestChangeFeed);
+	Run("functions", TestFunctions);
+
+	if (iFailures)
+	{
+		std::cout << iFailures << " failed" << std::endl;
+		return 1;
+	}
 	return 0;
 }
\ No newline at end of file
@@ -0,0 +1,66 @@
+//compile time benchmark, instantiates the statement machinery for wide tables
+//build the CompileBench project and compare the /Bt+ front end time and the size of CompileBench.obj between changes
+
+#include <string>
+#include "BrilliantDB.h"
+
+using namespace BrilliantDB;
+
+#define BENCH_MEMBERS_10(n) \
+	int i##n##0; double d##n##1; std::string s##n##2; int i##n##3; double d##n##4; \
+	std::string s##n##5; int i##n##6; double d##n##7; std::string s##n##8; int i##n##9;
+
+#define BENCH_COLUMNS_10(T, n) \
+	MakeColumn("i" #n "0", &T::i##n##0), MakeColumn("d" #n "1", &T::d##n##1), MakeColumn("s" #n "2", &T::s##n##2), \
+	MakeColumn("i" #n "3", &T::i##n##3), MakeColumn("d" #n "4", &T::d##n##4), MakeColumn("s" #n "5", &T::s##n##5), \
+	MakeColumn("i" #n "6", &T::i##n##6), MakeColumn("d" #n "7", &T::d##n##7), MakeColumn("s" #n "8", &T::s##n##8), \
+	MakeColumn("i" #n "9", &T::i##n##9)
+
+struct Wide20
+{
+	primary_key_t id;
+	BENCH_MEMBERS_10(0)
+	BENCH_MEMBERS_10(1)
+};
+
+struct Wide40
+{
+	primary_key_t id;
+	BENCH_MEMBERS_10(0)
+	BENCH_MEMBERS_10(1)
+	BENCH_MEMBERS_10(2)
+	BENCH_MEMBERS_10(3)
+};
+
+template<class D, class T, class U>
+void Exercise(const D& db, U T::* pFilter)
+{
+	T t{};
+	t.id = db.Insert(t);
+	db.Update(t);
+	auto obj = db.template Get<T>(t.id);
+	auto vAll = db.template GetAll<T>(Where(C(pFilter) > U{}));
+	db.template UpdateAll<T>(Set(C(pFilter) == U{}), Where(C(pFilter) < U{}));
+	db.Remove(t);
+}
+
+int main()
+{
+	auto db = MakeDatabase(":memory:",
+		MakeTable<Wide20>("Wide20",
+			MakeColumn("id", &Wide20::id, Constraint::primary_key, Constraint::auto_increment),
+			BENCH_COLUMNS_10(Wide20, 0),
+			BENCH_COLUMNS_10(Wide20, 1)
+			),
+		MakeTable<Wide40>("Wide40",
+			MakeColumn("id", &Wide40::id, Constraint::primary_key, Constraint::auto_increment),
+			BENCH_COLUMNS_10(Wide40, 0),
+			BENCH_COLUMNS_10(Wide40, 1),
+			BENCH_COLUMNS_10(Wide40, 2),
+			BENCH_COLUMNS_10(Wide40, 3)
+			)
+	);
+	Exercise(db, &Wide20::i00);
+	Exercise(db, &Wide40::d31);
+	return 0;
+}
\ No newline at end of file
@@ -2,6 +2,12 @@
 
 #include <algorithm>
 #include <concepts>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <optional>
+#include <ranges>
+#include <stdexcept>
 #include <tuple>
 #include <type_traits>
 #include <sqlite3.h>
@@ -10,9 +16,33 @@
 #include "detail/StatementPrinter.h"
 #include "detail/Connection.h"
 #include "detail/PreparedStatement.h"
+#include "detail/ObjectCache.h"
+#include "detail/Backup.h"
+#include "detail/Blob.h"
+#include "detail/Transaction.h"
+#include "detail/Query.h"
+#include "detail/Function.h"
+#include "detail/ChangeFeed.h"
+#include "detail/Session.h"
+#include "detail/Memory.h"
+#include "detail/Transfer.h"
+#include "detail/ResultCache.h"
+#include "detail/Busy.h"
+#include "detail/Interrupt.h"
+#include "detail/Checkpoint.h"
+#include "detail/Maintenance.h"
 
 namespace BrilliantDB
 {
+	//holds the fingerprint ReconcileSchema compares against, PRAGMA user_version is left to the application
+	inline constexpr const char* sSchemaTable = "BrilliantDB_schema";
+
+	//settings MakeDatabase applies before it creates any table
+	struct DatabaseOptions
+	{
+		std::optional<AutoVacuum> autoVacuum; //only a file without tables takes it, SetAutoVacuum converts an existing one
+	};
+
 	//Db_Impl allows us to use tuple-like subclass unfolding to find and store tables
 	template<class... Ts>
 	struct Db_Impl;
@@ -25,6 +55,8 @@ namespace BrilliantDB
 
 		template<class F>
 		void ForEachTable(F&& f) const {}
+
+		void ClearCaches() const {}
 	};
 
 	template<class T, class... Ts>
@@ -33,6 +65,7 @@ namespace BrilliantDB
 		Db_Impl(T t, Ts... ts) : tTable(std::move(t)), Db_Impl<Ts...>(ts...) {}
 
 		T tTable;
+		mutable ObjectCache<typename T::PrimaryType> tCache; //unsynchronized, see ObjectCache
 
 		template<class U> requires std::same_as<std::decay_t<U>,typename T::PrimaryType>
 		const T& GetTable() const
@@ -40,6 +73,18 @@ namespace BrilliantDB
 			return tTable;
 		}
 
+		template<class U> requires std::same_as<std::decay_t<U>, typename T::PrimaryType>
+		auto& GetCache() const
+		{
+			return tCache;
+		}
+
+		template<class U> requires !std::same_as<std::decay_t<U>, typename T::PrimaryType>
+		auto& GetCache() const
+		{
+			return Db_Impl<Ts...>::template GetCache<U>();
+		}
+
 		template<class U> requires !std::same_as<std::decay_t<U>,typename T::PrimaryType>
 		const auto& GetTable() const
 		{
@@ -59,6 +104,12 @@ namespace BrilliantDB
 			f(tTable);
 			Db_Impl<Ts...>::ForEachTable(f);
 		}
+
+		void ClearCaches() const
+		{
+			tCache.Clear();
+			Db_Impl<Ts...>::ClearCaches();
+		}
 	};
 
 	template<class... Ts>
@@ -67,49 +118,198 @@ namespace BrilliantDB
 		Database(std::string sDir, Ts&&... tables) noexcept(false); //connection can throw on instantiation
 
 		template<class T> auto Insert(const T& t) const;
-		template<class T> auto Get(primary_key_t k) const;
+		template<class T> auto Insert(const T& t, const ZeroBlob<T>& blob) const;
+		template<class T, class... Ks> auto Get(const Ks&... keys) const; //one value per primary key column
+		template<class T> std::optional<T> GetByRowid(primary_key_t k) const;
 		template<class T> void Update(const T& t) const;
 		template<class T, class... Us> std::vector<T> GetAll(Us&&... Args) const;
+		//result and its pmr string/blob members live on pResource, a monotonic resource frees them all at once
+		template<class T, class R, class... Us> requires std::derived_from<R, std::pmr::memory_resource>
+		std::pmr::vector<T> GetAll(R* pResource, Us&&... args) const;
 		template<class T, class... Us> void UpdateAll(Us&&... args) const;
 		template<class T> void Remove(const T& t) const;
 		template<class T, class... Us> void RemoveAll(Us&&... args) const;
+		//batched writes in one transaction with a single prepared statement, return the number of rows changed
+		template<class T, std::ranges::input_range R> std::size_t UpdateMany(const R& objects) const;
+		template<class T, std::ranges::input_range R> std::size_t RemoveMany(const R& objectsOrKeys) const;
 		
+		//events for a write are delivered once it commits, only tables keyed by a primary_key_t can be subscribed to since
+		//sqlite's update hook doesn't report rows of WITHOUT ROWID tables and a composite key doesn't fit ChangeEvent::key
+		//an exception thrown by a callback propagates out of the write that committed, after the other callbacks have run
+		template<class T, class F> std::size_t Subscribe(F&& f) const;
+		void Unsubscribe(std::size_t id) const { if (pFeed) { pFeed->Unsubscribe(id); } }
+		void DeliverChanges() const { if (pFeed) { pFeed->Deliver(); } }
+		[[nodiscard]] Transaction BeginTransaction(TransactionMode mode = TransactionMode::deferred) const { return Transaction(connection, [this]() { DeliverChanges(); }, mode); }
+
+		void SetBusyPolicy(const BusyPolicy& policy) const
+		{
+			auto pHandler = std::make_unique<BusyHandler>(policy);
+			pHandler->Install(connection.pDb);
+			pBusy = std::move(pHandler);
+		}
+		BusyStats GetBusyStats() const { return pBusy ? pBusy->stats : BusyStats{}; }
+
+		//statements run while the guard lives throw QueryTimeout or QueryCancelled once the limit is hit
+		[[nodiscard]] QueryGuard LimitQueries(const QueryLimit& limit) const { return QueryGuard(connection.pDb, pWatch, limit); }
+		//aborts whatever is running on the connection, safe to call from another thread
+		void Interrupt() const { sqlite3_interrupt(connection.pDb); }
+
+		//switches the file to wal and checkpoints it in the background, foreground commits no longer run automatic checkpoints
+		void StartCheckpointer(const CheckpointOptions& options = {}) const;
+		void StopCheckpointer() const { pCheckpointer.reset(); }
+		CheckpointStats GetCheckpointStats() const { return pCheckpointer ? pCheckpointer->Stats() : CheckpointStats{}; }
+		//runs on the checkpointer's connection when one is started, otherwise on this one
+		CheckpointResult Checkpoint(CheckpointMode mode = CheckpointMode::passive) const { return pCheckpointer ? pCheckpointer->Run(mode) : RunCheckpoint(connection.pDb, mode); }
+
+		//a database that already has tables is rebuilt with VACUUM to switch modes, call it outside a transaction
+		//new files should get their mode from DatabaseOptions instead, which costs nothing
+		void SetAutoVacuum(AutoVacuum mode) const;
+		sqlite3_int64 IncrementalVacuum(int iPages) const { return BrilliantDB::IncrementalVacuum(connection.pDb, iPages); }
+		void Analyze() const { ExecMaintenance(connection.pDb, "ANALYZE;"); }
+		void Optimize() const { ExecMaintenance(connection.pDb, "PRAGMA optimize;"); }
+		SpaceStats GetSpaceStats() const { return BrilliantDB::GetSpaceStats(connection.pDb); }
+		//vacuums and optimizes on a schedule, and optimizes once more when stopped or when the database closes
+		//outside wal mode its writes lock readers out briefly, give this connection a busy policy
+		void StartMaintenance(const MaintenanceOptions& options = {}) const
+		{
+			pMaintainer.reset();
+			pMaintainer = std::make_unique<Maintainer>(connection.pDb, options);
+		}
+		void StopMaintenance() const { pMaintainer.reset(); }
+		MaintenanceStats GetMaintenanceStats() const { return pMaintainer ? pMaintainer->Stats() : MaintenanceStats{}; }
+
+#if defined(SQLITE_ENABLE_SESSION) && defined(SQLITE_ENABLE_PREUPDATE_HOOK)
+		//records changes to the tables of Us, or to every table when Us is empty
+		template<class... Us> Session CreateSession() const;
+		void ApplyChangeset(const Changeset& changes, ConflictPolicy policy = ConflictPolicy::abort) const;
+#endif
+
+		ConnectionMemoryStats GetMemoryStats(bool bReset = false) const { return GetConnectionMemoryStats(connection.pDb, bReset); }
+
+		//streams every row of T with bounded memory, return the number of rows written or loaded
+		template<class T> std::size_t Export(std::ostream& os, TransferFormat format = TransferFormat::csv) const;
+		template<class T> std::size_t Import(std::istream& is, TransferFormat format = TransferFormat::csv) const;
+
+		template<class F> void RegisterFunction(const std::string& sName, F&& f, bool bDeterministic = true) const;
+
+		template<class S> Query<Database, S> MakeQuery(const S& statement) const { return { *this, statement }; }
+		template<class T, class... Us> auto Prefetch(std::size_t iCapacity, Us&&... args) const;
+
+		template<class T> BlobHandle OpenBlob(primary_key_t k, std::vector<char> T::* p, bool bWrite = false) const;
+
+		template<class T> void SetCacheCapacity(std::size_t n) const { Db_Impl<Ts...>::template GetCache<T>().SetCapacity(n); }
+		template<class T> void ClearCache() const { Db_Impl<Ts...>::template GetCache<T>().Clear(); }
+		template<class T> CacheStats GetCacheStats() const { return Db_Impl<Ts...>::template GetCache<T>().stats; }
+
+		//opt-in cache of GetAll and Query::Run results, only writes made through this Database invalidate it
+		void EnableResultCache(const ResultCacheOptions& options = {}) const { pResults = std::make_unique<ResultCache>(options); }
+		void DisableResultCache() const { pResults.reset(); }
+		CacheStats GetResultCacheStats() const { return pResults ? pResults->stats : CacheStats{}; }
+		template<class T> void InvalidateResults() const { if (pResults) { pResults->Invalidate(GetTableName<T>()); } }
+		void ClearCaches() const
+		{
+			Db_Impl<Ts...>::ClearCaches();
+			if (pResults) { pResults->Clear(); }
+		}
+		//runs a prepared select to completion, or returns the cached rows of an identical earlier run
+		template<class T, class S> std::vector<T> Materialize(const PreparedStatement<S>& stmt) const;
+
 		template<class T> std::string GetTableName() const { return Db_Impl<Ts...>::template GetTable<T>().sName; }
 		template<class T, class U> std::string GetColumnName(U T::* p) const;
 
+		void CreateTables() const;
 		void UpdateSchema() const;
+		//creates and extends the tables when their definitions changed since the fingerprint stored in sSchemaTable
+		void ReconcileSchema() const;
+		int SchemaFingerprint() const;
+		void LoadSnapshot(const std::string& sFile, const BackupOptions& options = {}) const;
+		void SaveSnapshot(const std::string& sFile, const BackupOptions& options = {}) const;
 		template<class T> std::vector<TableInfo> GetTableInfo() const;
 
 		template<class U, class... Us>
-		std::optional<U> Execute(const PreparedStatement<GetStatement<U, Us...>>& stmt) const
+		std::optional<U> Execute(const PreparedStatement<GetStatement<U, Us...>>& stmt, std::pmr::memory_resource* pResource = std::pmr::get_default_resource()) const
 		{
+			if (!sqlite3_stmt_busy(stmt.pStmt)) { ArmWatch(); }
 			switch (sqlite3_step(stmt.pStmt))
 			{
 			case SQLITE_DONE:
+				DeliverChanges();
 				return std::nullopt;
 			case SQLITE_ROW:
-				return Build<U>(stmt, Db_Impl<Ts...>::template GetTable<U>().tCols);
+				return Build<U>(stmt, Db_Impl<Ts...>::template GetTable<U>().tCols, pResource);
 			default:
-				ThrowError(connection.pDb);
+				sqlite3_reset(stmt.pStmt); //ends the failed statement's implicit transaction so a retry can succeed
+				ThrowStepError(connection.pDb, pWatch);
 			}
 		}
 
 		template<class U>
 		auto Execute(const PreparedStatement<U>& stmt) const
 		{
+			if constexpr (requires { typename U::TableType; }) { InvalidateResults<typename U::TableType>(); }
+			if (!sqlite3_stmt_busy(stmt.pStmt)) { ArmWatch(); }
 			switch (sqlite3_step(stmt.pStmt))
 			{
 			case SQLITE_DONE:
+				DeliverChanges();
 				return false;
 			case SQLITE_ROW:
 				return true;
 			default:
-				ThrowError(connection.pDb);
+				sqlite3_reset(stmt.pStmt);
+				ThrowStepError(connection.pDb, pWatch);
 			}
 			return false;
 		}
 
+		//prepares the insert of t's columns, the rowid key left out, and calls fBind(stmt, column, parameter index) for each before it runs
+		template<class T, class F>
+		primary_key_t InsertWith(const T& t, F&& fBind) const;
+
+		//steps a write to completion and finalizes it, also when a step throws, so a failed write leaves nothing open on the connection
+		template<class U>
+		void ExecuteAll(PreparedStatement<U>& stmt) const
+		{
+			try
+			{
+				while (Execute(stmt));
+			}
+			catch (...)
+			{
+				sqlite3_finalize(stmt.pStmt);
+				throw;
+			}
+			stmt.Finalize(connection);
+		}
+
+		//single row lookup that finalizes the statement whether or not the step throws
+		template<class U>
+		auto ExecuteOnce(PreparedStatement<U>& stmt) const
+		{
+			decltype(Execute(stmt)) obj;
+			try
+			{
+				obj = Execute(stmt);
+			}
+			catch (...)
+			{
+				sqlite3_finalize(stmt.pStmt);
+				throw;
+			}
+			stmt.Finalize(connection);
+			return obj;
+		}
+
+		//restarts the limits of the active guards for the query about to run
+		void ArmWatch() const { if (pWatch) { pWatch->Arm(); } }
+
 		Connection connection;
+		mutable std::unique_ptr<ChangeFeed> pFeed; //declared after connection so the hooks are removed before it closes
+		mutable std::unique_ptr<ResultCache> pResults;
+		mutable std::unique_ptr<BusyHandler> pBusy; //the connection keeps a pointer to it until the policy changes
+		mutable QueryWatch* pWatch = nullptr; //owned by the innermost QueryGuard
+		mutable std::unique_ptr<Checkpointer> pCheckpointer; //declared after connection so its thread stops before the connection closes
+		mutable std::unique_ptr<Maintainer> pMaintainer; //same, and its optimize on close still has a connection to run on
 	};
 
 	template<class... Ts>
@@ -119,6 +319,38 @@ namespace BrilliantDB
 		
 	}
 
+	template<class... Ts>
+	void Database<Ts...>::StartCheckpointer(const CheckpointOptions& options) const
+	{
+		pCheckpointer.reset();
+		std::string sMode;
+		if (sqlite3_exec(connection.pDb, "PRAGMA journal_mode=WAL;", [](void* data, int argc, char** argv, char**) -> int {
+				if (argc && argv[0]) { *static_cast<std::string*>(data) = argv[0]; }
+				return 0;
+			}, &sMode, nullptr) != SQLITE_OK)
+		{
+			ThrowError(connection.pDb);
+		}
+		if (sMode != "wal")
+		{
+			throw std::runtime_error("background checkpoints need a file database in wal mode");
+		}
+		pCheckpointer = std::make_unique<Checkpointer>(connection.pDb, options);
+	}
+
+	template<class... Ts>
+	void Database<Ts...>::SetAutoVacuum(AutoVacuum mode) const
+	{
+		std::string sql = "PRAGMA auto_vacuum = " + std::to_string(static_cast<int>(mode)) + ";";
+		ExecMaintenance(connection.pDb, sql.c_str());
+		//only takes effect by itself on an empty file
+		if (static_cast<AutoVacuum>(PragmaValue(connection.pDb, "auto_vacuum")) != mode)
+		{
+			ExecMaintenance(connection.pDb, "VACUUM;");
+			ClearCaches(); //rowids that aren't an INTEGER PRIMARY KEY may change
+		}
+	}
+
 	template<class... Ts>
 	template<class T, class U>
 	[[nodiscard]] std::string Database<Ts...>::GetColumnName(U T::* p) const
@@ -141,8 +373,8 @@ namespace BrilliantDB
 	}
 
 	template<class... Ts>
-	template<class T>
-	[[nodiscard]] auto Database<Ts...>::Insert(const T& t) const
+	template<class T, class F>
+	primary_key_t Database<Ts...>::InsertWith(const T& t, F&& fBind) const
 	{
 		auto table = Db_Impl<Ts...>::template GetTable<T>();
 		auto tpl = TupleUtils::BuildFromOther([&](const auto& item)->auto
@@ -152,22 +384,150 @@ namespace BrilliantDB
 				return C(item.pMember) == t.*item.pMember;
 			}, table.tCols);
 
-		auto ins = BrilliantDB::Insert<T>(tpl);
 		auto stmt = Prepare(BrilliantDB::Insert<T>(tpl), *this);
-		while (Execute(stmt));
-		stmt.Finalize(connection);
+		try
+		{
+			int iIndex = 1; //parameters follow the order of tpl
+			TupleUtils::for_each_tuple(tpl, [&](const auto& item) { fBind(stmt, item, iIndex++); });
+		}
+		catch (...)
+		{
+			sqlite3_finalize(stmt.pStmt);
+			throw;
+		}
+		ExecuteAll(stmt);
 		return primary_key_t{ sqlite3_last_insert_rowid(connection.pDb) };
 	}
 
 	template<class... Ts>
 	template<class T>
-	[[nodiscard]] auto Database<Ts...>::Get(primary_key_t k) const
+	[[nodiscard]] auto Database<Ts...>::Insert(const T& t) const
+	{
+		return InsertWith(t, [](const auto&, const auto&, int) {});
+	}
+
+	template<class... Ts>
+	template<class T>
+	[[nodiscard]] auto Database<Ts...>::Insert(const T& t, const ZeroBlob<T>& blob) const
+	{
+		if (GetColumnName(blob.pMember).empty())
+		{
+			throw std::runtime_error("the zeroblob member isn't a column of the table");
+		}
+		//rebinds the reserved column in place of the member's own value
+		return InsertWith(t, [&](const auto& stmt, const auto& item, int iIndex) {
+			if constexpr (std::is_same_v<typename std::decay_t<decltype(item)>::FieldType, std::vector<char>>)
+			{
+				if (item.pMember == blob.pMember && sqlite3_bind_zeroblob64(stmt.pStmt, iIndex, blob.iSize) != SQLITE_OK)
+				{
+					ThrowError(connection.pDb);
+				}
+			}
+			});
+	}
+
+	template<class... Ts>
+	template<class T, class F>
+	std::size_t Database<Ts...>::Subscribe(F&& f) const
+	{
+		using TableType = std::decay_t<decltype(Db_Impl<Ts...>::template GetTable<T>())>;
+		static_assert(TableType::bHasRowidKey, "change events need a table keyed by a primary_key_t");
+		if (!pFeed)
+		{
+			pFeed = std::make_unique<ChangeFeed>(connection.pDb);
+		}
+		return pFeed->Subscribe(GetTableName<T>(), [f = std::forward<F>(f)](ChangeType type, sqlite3_int64 iRow) {
+			f(ChangeEvent<T>{ type, primary_key_t{ iRow } });
+			});
+	}
+
+#if defined(SQLITE_ENABLE_SESSION) && defined(SQLITE_ENABLE_PREUPDATE_HOOK)
+	template<class... Ts>
+	template<class... Us>
+	[[nodiscard]] Session Database<Ts...>::CreateSession() const
+	{
+		Session session(connection.pDb);
+		if constexpr (sizeof...(Us) == 0)
+		{
+			session.Attach("");
+		}
+		else
+		{
+			(session.Attach(GetTableName<Us>()), ...);
+		}
+		return session;
+	}
+
+	template<class... Ts>
+	void Database<Ts...>::ApplyChangeset(const Changeset& changes, ConflictPolicy policy) const
+	{
+		BrilliantDB::ApplyChangeset(connection.pDb, changes, policy);
+		ClearCaches();
+		DeliverChanges();
+	}
+#endif
+
+	template<class... Ts>
+	template<class F>
+	void Database<Ts...>::RegisterFunction(const std::string& sName, F&& f, bool bDeterministic) const
+	{
+		using FunctionType = std::decay_t<F>;
+		constexpr int iArgs = static_cast<int>(std::tuple_size_v<typename function_traits<FunctionType>::ArgTypes>);
+		const int iFlags = SQLITE_UTF8 | (bDeterministic ? SQLITE_DETERMINISTIC : 0);
+		//sqlite3 calls DestroyFunction on the copy even when registration fails
+		if (sqlite3_create_function_v2(connection.pDb, sName.c_str(), iArgs, iFlags, new FunctionType(std::forward<F>(f)),
+			&InvokeFunction<FunctionType>, nullptr, nullptr, &DestroyFunction<FunctionType>) != SQLITE_OK)
+		{
+			ThrowError(connection.pDb);
+		}
+	}
+
+	template<class... Ts>
+	template<class T>
+	[[nodiscard]] BlobHandle Database<Ts...>::OpenBlob(primary_key_t k, std::vector<char> T::* p, bool bWrite) const
+	{
+		if (bWrite)
+		{
+			Db_Impl<Ts...>::template GetCache<T>().Erase(k._t);
+			InvalidateResults<T>();
+		}
+		return BlobHandle(connection.pDb, GetTableName<T>(), GetColumnName(p), k._t, bWrite);
+	}
+
+	template<class... Ts>
+	template<class T, class... Ks>
+	[[nodiscard]] auto Database<Ts...>::Get(const Ks&... keys) const
+	{
+		using TableType = std::decay_t<decltype(Db_Impl<Ts...>::template GetTable<T>())>;
+		if constexpr (!TableType::bHasRowidKey)
+		{
+			auto stmt = Prepare(Select<T>(WhereKey<T>(keys...)), *this);
+			return ExecuteOnce(stmt);
+		}
+		else
+		{
+			return GetByRowid<T>(primary_key_t(keys...));
+		}
+	}
+
+	template<class... Ts>
+	template<class T>
+	[[nodiscard]] std::optional<T> Database<Ts...>::GetByRowid(primary_key_t k) const
 	{
+		auto& cache = Db_Impl<Ts...>::template GetCache<T>();
+		if (cache.Enabled())
+		{
+			if (auto cached = cache.Find(k._t))
+			{
+				return cached;
+			}
+		}
+
 		auto table = Db_Impl<Ts...>::template GetTable<T>();
 		auto col = table.template GetColumn<primary_key_t>();
 		auto stmt = Prepare(Select<T>(Where(C(col.pMember) == k)), *this);
-		auto obj = Execute(stmt);
-		stmt.Finalize(connection);
+		auto obj = ExecuteOnce(stmt);
+		if (obj) { cache.Put(k._t, *obj); }
 		return obj;
 	}
 
@@ -184,33 +544,200 @@ namespace BrilliantDB
 				return C(item.pMember) == t.*item.pMember;
 			}, table.tCols);
 		
-		auto col = table.template GetColumn<primary_key_t>();
-		UpdateAll<T>(SetStatement{ tpl }, Where(C(col.pMember) == t.*col.pMember));
+		if constexpr (!std::decay_t<decltype(table)>::bHasRowidKey)
+		{
+			auto stmt = Prepare(BrilliantDB::Update<T>(SetStatement{ tpl }, WhereKey<T>(ObjectKey<T, std::decay_t<decltype(table)>>{ t, table })), *this);
+			ExecuteAll(stmt);
+		}
+		else
+		{
+			auto col = table.template GetColumn<primary_key_t>();
+			auto stmt = Prepare(BrilliantDB::Update<T>(SetStatement{ tpl }, Where(C(col.pMember) == t.*col.pMember)), *this);
+			ExecuteAll(stmt);
+
+			auto& cache = Db_Impl<Ts...>::template GetCache<T>();
+			if (sqlite3_changes(connection.pDb)) { cache.Put((t.*col.pMember)._t, t); }
+			else { cache.Erase((t.*col.pMember)._t); }
+		}
 	}
 
 	template<class... Ts>
 	template<class T, class... Us>
 	[[nodiscard]] std::vector<T> Database<Ts...>::GetAll(Us&&... args) const
 	{
-		std::vector<T> vRet;
-		auto table = Db_Impl<Ts...>::template GetTable<T>();
-		auto col = table.template GetColumn<primary_key_t>();
 		auto stmt = Prepare(Select<T>(std::forward<Us>(args)...), *this);
+		std::vector<T> vRet;
+		try
+		{
+			vRet = Materialize<T>(stmt);
+		}
+		catch (...)
+		{
+			sqlite3_finalize(stmt.pStmt);
+			throw;
+		}
+		stmt.Finalize(connection);
+		return vRet;
+	}
+
+	template<class... Ts>
+	template<class T, class S>
+	std::vector<T> Database<Ts...>::Materialize(const PreparedStatement<S>& stmt) const
+	{
+		std::string sKey;
+		if (pResults)
+		{
+			//bound values are inlined into the expanded sql, so it identifies the result
+			char* pSql = sqlite3_expanded_sql(stmt.pStmt);
+			if (pSql)
+			{
+				sKey = pSql;
+				sqlite3_free(pSql);
+			}
+			if (auto pRows = pResults->Find<T>(sKey)) { return *pRows; }
+		}
+
+		std::vector<T> vRet;
 		while (auto obj = Execute(stmt))
 		{
-			vRet.push_back(*obj);
+			vRet.push_back(std::move(*obj));
+		}
+
+		//rows read inside a transaction may still be rolled back
+		if (pResults && !sKey.empty() && sqlite3_get_autocommit(connection.pDb))
+		{
+			std::size_t iBytes = sKey.size() + vRet.size() * sizeof(T);
+			TupleUtils::for_each_tuple(Db_Impl<Ts...>::template GetTable<T>().tCols, [&](auto& col) {
+				if constexpr (!is_foreign_key<std::decay_t<decltype(col)>>::value)
+				{
+					using FieldType = typename std::decay_t<decltype(col)>::FieldType;
+					if constexpr (requires (const FieldType& f) { f.size(); })
+					{
+						for (const auto& t : vRet) { iBytes += (t.*col.pMember).size(); }
+					}
+				}
+				});
+			pResults->Put(sKey, GetTableName<T>(), vRet, iBytes);
+		}
+		return vRet;
+	}
+
+	template<class... Ts>
+	template<class T, class R, class... Us> requires std::derived_from<R, std::pmr::memory_resource>
+	[[nodiscard]] std::pmr::vector<T> Database<Ts...>::GetAll(R* pResource, Us&&... args) const
+	{
+		std::pmr::vector<T> vRet(pResource);
+		auto stmt = Prepare(Select<T>(std::forward<Us>(args)...), *this);
+		try
+		{
+			while (auto obj = Execute(stmt, pResource))
+			{
+				vRet.push_back(std::move(*obj)); //a copy would put pmr members back on the default resource
+			}
+		}
+		catch (...)
+		{
+			sqlite3_finalize(stmt.pStmt);
+			throw;
 		}
 		stmt.Finalize(connection);
 		return vRet;
 	}
 
+	template<class... Ts>
+	template<class T>
+	std::size_t Database<Ts...>::Export(std::ostream& os, TransferFormat format) const
+	{
+		auto Run = [&]<class Format>(Format) {
+			auto stmt = Prepare(Select<T>(), *this);
+			std::vector<std::string> vNames;
+			for (int i = 0; i < sqlite3_column_count(stmt.pStmt); i++) { vNames.emplace_back(sqlite3_column_name(stmt.pStmt, i)); }
+			Format::WriteHeader(os, vNames);
+
+			//values are copied straight from the statement, no row is built
+			std::size_t iRows = 0;
+			int rc;
+			ArmWatch();
+			while ((rc = sqlite3_step(stmt.pStmt)) == SQLITE_ROW)
+			{
+				Format::WriteRow(os, stmt.pStmt);
+				iRows++;
+			}
+			if (rc != SQLITE_DONE)
+			{
+				sqlite3_finalize(stmt.pStmt);
+				ThrowStepError(connection.pDb, pWatch);
+			}
+			stmt.Finalize(connection);
+			Format::WriteEnd(os);
+			return iRows;
+		};
+		return format == TransferFormat::csv ? Run(CsvFormat()) : Run(BinaryFormat());
+	}
+
+	template<class... Ts>
+	template<class T>
+	std::size_t Database<Ts...>::Import(std::istream& is, TransferFormat format) const
+	{
+		InvalidateResults<T>();
+		auto Run = [&]<class Format>(Format) {
+			auto vNames = Format::ReadHeader(is);
+			std::string sInsert = "INSERT INTO \"" + Db_Impl<Ts...>::template GetTable<T>().sName + "\" (";
+			std::string sValues;
+			for (std::size_t i = 0; i < vNames.size(); i++)
+			{
+				sInsert += (i ? ", \"" : "\"");
+				for (char c : vNames[i]) { sInsert += (c == '"' ? "\"\"" : std::string(1, c)); }
+				sInsert += '"';
+				sValues += (i ? ", ?" : "?");
+			}
+			sInsert += ") VALUES (" + sValues + ")";
+
+			std::optional<Transaction> transaction;
+			if (sqlite3_get_autocommit(connection.pDb)) { transaction.emplace(connection, [this]() { DeliverChanges(); }, TransactionMode::immediate); }
+
+			sqlite3_stmt* pRaw = nullptr;
+			if (sqlite3_prepare_v2(connection.pDb, sInsert.c_str(), -1, &pRaw, nullptr) != SQLITE_OK)
+			{
+				ThrowError(connection.pDb);
+			}
+			std::unique_ptr<sqlite3_stmt, decltype(&sqlite3_finalize)> pStmt(pRaw, &sqlite3_finalize);
+
+			std::size_t iRows = 0;
+			ArmWatch(); //the whole import is one query, the statement is reset per row
+			while (Format::ReadRow(is, pStmt.get(), vNames.size()))
+			{
+				if (sqlite3_step(pStmt.get()) != SQLITE_DONE)
+				{
+					ThrowStepError(connection.pDb, pWatch);
+				}
+				sqlite3_reset(pStmt.get());
+				iRows++;
+			}
+			pStmt.reset();
+			if (transaction) { transaction->Commit(); }
+			return iRows;
+		};
+		auto iRows = format == TransferFormat::csv ? Run(CsvFormat()) : Run(BinaryFormat());
+		Db_Impl<Ts...>::template GetCache<T>().Clear();
+		return iRows;
+	}
+
+	template<class... Ts>
+	template<class T, class... Us>
+	[[nodiscard]] auto Database<Ts...>::Prefetch(std::size_t iCapacity, Us&&... args) const
+	{
+		auto statement = Select<T>(std::forward<Us>(args)...);
+		return PrefetchCursor<Database, decltype(statement)>(*this, Prepare(statement, *this), true, iCapacity);
+	}
+
 	template<class... Ts>
 	template<class T, class... Us>
 	void Database<Ts...>::UpdateAll(Us&&... args) const
 	{
 		auto stmt = Prepare(BrilliantDB::Update<T>(std::forward<Us>(args)...), *this);
-		while (Execute(stmt));
-		stmt.Finalize(connection);
+		ExecuteAll(stmt);
+		Db_Impl<Ts...>::template GetCache<T>().Clear(); //can't tell which rows the predicate touched
 	}
 
 	template<class... Ts>
@@ -218,8 +745,18 @@ namespace BrilliantDB
 	void Database<Ts...>::Remove(const T& t) const
 	{
 		auto& table = Db_Impl<Ts...>::template GetTable<T>();
-		auto col = table.template GetColumn<primary_key_t>();
-		RemoveAll<T>(Where(C(col.pMember) == t.*col.pMember));
+		if constexpr (!std::decay_t<decltype(table)>::bHasRowidKey)
+		{
+			auto stmt = Prepare(Delete<T>(WhereKey<T>(ObjectKey<T, std::decay_t<decltype(table)>>{ t, table })), *this);
+			ExecuteAll(stmt);
+		}
+		else
+		{
+			auto col = table.template GetColumn<primary_key_t>();
+			auto stmt = Prepare(Delete<T>(Where(C(col.pMember) == t.*col.pMember)), *this);
+			ExecuteAll(stmt);
+			Db_Impl<Ts...>::template GetCache<T>().Erase((t.*col.pMember)._t);
+		}
 	}
 
 	template<class... Ts>
@@ -227,8 +764,255 @@ namespace BrilliantDB
 	void Database<Ts...>::RemoveAll(Us&&... args) const
 	{
 		auto stmt = Prepare(Delete<T>(std::forward<Us>(args)...), *this);
-		while (Execute(stmt));
+		ExecuteAll(stmt);
+		Db_Impl<Ts...>::template GetCache<T>().Clear();
+	}
+
+	template<class... Ts>
+	template<class T, std::ranges::input_range R>
+	std::size_t Database<Ts...>::UpdateMany(const R& objects) const
+	{
+		auto& table = Db_Impl<Ts...>::template GetTable<T>();
+		using TableType = std::decay_t<decltype(table)>;
+		auto MakeSet = [&table](const T& t) {
+			return TupleUtils::BuildFromOther([&](const auto& item)->auto
+				requires !is_foreign_key<std::decay_t<decltype(item)>>::value &&
+					!is_primary_key<std::decay_t<decltype(item)>>::value
+				{
+					return C(item.pMember) == t.*item.pMember;
+				}, table.tCols);
+		};
+		auto MakeWhere = [&table](const T& t) {
+			if constexpr (TableType::bHasRowidKey)
+			{
+				auto col = table.template GetColumn<primary_key_t>();
+				auto c = C(col.pMember);
+				c.value = t.*col.pMember;
+				return Where(std::move(c)); //hold the comparison by value, the statement outlives this lambda
+			}
+			else
+			{
+				return WhereKey<T>(ObjectKey<T, TableType>{ t, table });
+			}
+		};
+
+		auto it = std::ranges::begin(objects);
+		if (it == std::ranges::end(objects)) { return 0; }
+
+		std::optional<Transaction> transaction;
+		if (sqlite3_get_autocommit(connection.pDb)) { transaction.emplace(connection, [this]() { DeliverChanges(); }, TransactionMode::immediate); }
+
+		std::size_t iChanged = 0;
+		auto& cache = Db_Impl<Ts...>::template GetCache<T>();
+		auto stmt = Prepare(BrilliantDB::Update<T>(SetStatement{ MakeSet(*it) }, MakeWhere(*it)), *this);
+		try
+		{
+			for (; it != std::ranges::end(objects); ++it)
+			{
+				const T& t = *it;
+				sqlite3_reset(stmt.pStmt);
+				Binder binder{ connection, stmt };
+				TupleUtils::for_each_tuple(MakeSet(t), binder);
+				TupleUtils::for_each_tuple(TupleUtils::Flatten(TupleUtils::BuildFromOther(Extractor(), std::make_tuple(MakeWhere(t)))), binder);
+				while (Execute(stmt));
+
+				auto iRowChanges = sqlite3_changes(connection.pDb);
+				iChanged += iRowChanges;
+				if constexpr (TableType::bHasRowidKey)
+				{
+					auto col = table.template GetColumn<primary_key_t>();
+					if (iRowChanges) { cache.Put((t.*col.pMember)._t, t); }
+					else { cache.Erase((t.*col.pMember)._t); }
+				}
+			}
+		}
+		catch (...)
+		{
+			sqlite3_finalize(stmt.pStmt);
+			cache.Clear();
+			throw;
+		}
 		stmt.Finalize(connection);
+		if (transaction) { transaction->Commit(); }
+		return iChanged;
+	}
+
+	template<class... Ts>
+	template<class T, std::ranges::input_range R>
+	std::size_t Database<Ts...>::RemoveMany(const R& objectsOrKeys) const
+	{
+		InvalidateResults<T>();
+		auto& table = Db_Impl<Ts...>::template GetTable<T>();
+		using TableType = std::decay_t<decltype(table)>;
+		using ValueType = std::ranges::range_value_t<R>;
+
+		std::optional<Transaction> transaction;
+		if (sqlite3_get_autocommit(connection.pDb)) { transaction.emplace(connection, [this]() { DeliverChanges(); }, TransactionMode::immediate); }
+
+		std::size_t iChanged = 0;
+		if constexpr (!TableType::bHasRowidKey)
+		{
+			//natural keys can't be packed into a single IN list, reuse one keyed delete instead
+			static_assert(std::is_same_v<ValueType, T>, "tables without a rowid key are removed by object");
+			auto it = std::ranges::begin(objectsOrKeys);
+			if (it == std::ranges::end(objectsOrKeys)) { return 0; }
+			auto stmt = Prepare(Delete<T>(WhereKey<T>(ObjectKey<T, TableType>{ *it, table })), *this);
+			try
+			{
+				for (; it != std::ranges::end(objectsOrKeys); ++it)
+				{
+					sqlite3_reset(stmt.pStmt);
+					Binder binder{ connection, stmt };
+					binder(ObjectKey<T, TableType>{ *it, table });
+					while (Execute(stmt));
+					iChanged += sqlite3_changes(connection.pDb);
+				}
+			}
+			catch (...)
+			{
+				sqlite3_finalize(stmt.pStmt);
+				throw;
+			}
+			stmt.Finalize(connection);
+		}
+		else
+		{
+			constexpr std::size_t iChunk = 256;
+			auto col = table.template GetColumn<primary_key_t>();
+			std::vector<sqlite3_int64> vKeys;
+			for (const auto& item : objectsOrKeys)
+			{
+				if constexpr (std::is_same_v<ValueType, T>) { vKeys.push_back((item.*col.pMember)._t); }
+				else { vKeys.push_back(primary_key_t(item)._t); }
+			}
+
+			using StatementPtr = std::unique_ptr<sqlite3_stmt, decltype(&sqlite3_finalize)>;
+			auto PrepareChunk = [&](std::size_t n) {
+				std::string sql = "DELETE FROM '" + table.sName + "' WHERE \"" + col.sName + "\" IN (";
+				for (std::size_t i = 0; i < n; i++) { sql += i ? ",?" : "?"; }
+				sql += ");";
+				sqlite3_stmt* pRaw = nullptr;
+				if (sqlite3_prepare_v2(connection.pDb, sql.c_str(), -1, &pRaw, nullptr) != SQLITE_OK)
+				{
+					ThrowError(connection.pDb);
+				}
+				return StatementPtr(pRaw, &sqlite3_finalize);
+			};
+
+			auto& cache = Db_Impl<Ts...>::template GetCache<T>();
+			StatementPtr pFull(nullptr, &sqlite3_finalize);
+			ArmWatch();
+			for (std::size_t iStart = 0; iStart < vKeys.size(); iStart += iChunk)
+			{
+				std::size_t n = std::min(iChunk, vKeys.size() - iStart);
+				StatementPtr pTail(nullptr, &sqlite3_finalize);
+				if (n != iChunk) { pTail = PrepareChunk(n); }
+				else if (!pFull) { pFull = PrepareChunk(iChunk); }
+				sqlite3_stmt* pStmt = pTail ? pTail.get() : pFull.get();
+				sqlite3_reset(pStmt);
+				for (std::size_t i = 0; i < n; i++) { sqlite3_bind_int64(pStmt, static_cast<int>(i + 1), vKeys[iStart + i]); }
+				if (sqlite3_step(pStmt) != SQLITE_DONE)
+				{
+					ThrowStepError(connection.pDb, pWatch);
+				}
+				iChanged += sqlite3_changes(connection.pDb);
+				for (std::size_t i = 0; i < n; i++) { cache.Erase(vKeys[iStart + i]); }
+			}
+		}
+
+		if (transaction) { transaction->Commit(); }
+		return iChanged;
+	}
+
+	template<class... Ts>
+	void Database<Ts...>::CreateTables() const
+	{
+		Db_Impl<Ts...>::ForEachTable([&](auto& table) {
+			if (sqlite3_exec(connection.pDb, Print(table, *this).c_str(), NULL, NULL, NULL) != SQLITE_OK)
+			{
+				ThrowError(connection.pDb);
+			}
+			});
+	}
+
+	template<class... Ts>
+	void Database<Ts...>::LoadSnapshot(const std::string& sFile, const BackupOptions& options) const
+	{
+		Connection source(sFile, SQLITE_OPEN_READONLY | SQLITE_OPEN_URI);
+		Backup(source.pDb, connection.pDb, options);
+		ClearCaches();
+		ReconcileSchema();
+	}
+
+	template<class... Ts>
+	void Database<Ts...>::SaveSnapshot(const std::string& sFile, const BackupOptions& options) const
+	{
+		Connection dest(sFile);
+		Backup(connection.pDb, dest.pDb, options);
+	}
+
+	//FNV-1a over the generated DDL, stored in PRAGMA user_version to skip reconciliation on unchanged schemas
+	template<class... Ts>
+	int Database<Ts...>::SchemaFingerprint() const
+	{
+		std::uint32_t iHash = 2166136261u;
+		Db_Impl<Ts...>::ForEachTable([&](auto& table) {
+			for (auto c : Print(table, *this))
+			{
+				iHash = (iHash ^ static_cast<unsigned char>(c)) * 16777619u;
+			}
+			});
+		int iRet = static_cast<int>(iHash & 0x7fffffff);
+		return iRet ? iRet : 1; //0 stands for a database that has no fingerprint yet
+	}
+
+	template<class... Ts>
+	void Database<Ts...>::ReconcileSchema() const
+	{
+		auto ReadInt = [](void* data, int argc, char** argv, char**) -> int {
+			*static_cast<int*>(data) = argc && argv[0] ? std::atoi(argv[0]) : 0;
+			return 0;
+		};
+		int iExists = 0, iStored = 0;
+		const std::string sExists = std::string("SELECT count(*) FROM sqlite_master WHERE type = 'table' AND name = '") + sSchemaTable + "';";
+		if (sqlite3_exec(connection.pDb, sExists.c_str(), ReadInt, &iExists, nullptr) != SQLITE_OK)
+		{
+			ThrowError(connection.pDb);
+		}
+		const std::string sStored = std::string("SELECT fingerprint FROM \"") + sSchemaTable + "\";";
+		if (iExists && sqlite3_exec(connection.pDb, sStored.c_str(), ReadInt, &iStored, nullptr) != SQLITE_OK)
+		{
+			ThrowError(connection.pDb);
+		}
+
+		const int iFingerprint = SchemaFingerprint();
+		if (iStored == iFingerprint)
+		{
+			return;
+		}
+
+		Transaction transaction(connection);
+		CreateTables();
+		UpdateSchema();
+		//an index created over existing rows starts out empty, only worth redoing when the schema changed
+		Db_Impl<Ts...>::ForEachTable([&](auto& table) {
+			if constexpr (requires { typename std::decay_t<decltype(table)>::ContentType; })
+			{
+				std::string sRebuild = "INSERT INTO \"" + table.sName + "\"(\"" + table.sName + "\") VALUES ('rebuild');";
+				if (sqlite3_exec(connection.pDb, sRebuild.c_str(), nullptr, nullptr, nullptr) != SQLITE_OK)
+				{
+					ThrowError(connection.pDb);
+				}
+			}
+			});
+		const std::string sTable = std::string("\"") + sSchemaTable + "\"";
+		std::string sql = "CREATE TABLE IF NOT EXISTS " + sTable + " (fingerprint INTEGER NOT NULL);DELETE FROM " + sTable + ";"
+			+ "INSERT INTO " + sTable + " (fingerprint) VALUES (" + std::to_string(iFingerprint) + ");";
+		if (sqlite3_exec(connection.pDb, sql.c_str(), nullptr, nullptr, nullptr) != SQLITE_OK)
+		{
+			ThrowError(connection.pDb);
+		}
+		transaction.Commit();
 	}
 
 	template<class... Ts>
@@ -285,17 +1069,24 @@ namespace BrilliantDB
 	}
 
 	//Maker functions
-	template<class... Ts>
+	template<class... Ts> requires (!std::same_as<std::decay_t<Ts>, DatabaseOptions> && ...)
 	[[nodiscard]] Database<Ts...> MakeDatabase(std::string dir, Ts&&... tables)
 	{
 		Database<Ts...> db{ std::move(dir), std::forward<Ts>(tables)... };
-		db.ForEachTable([&db](auto& table) {
-			if (sqlite3_exec(db.connection.pDb, Print(table, db).c_str(), NULL, NULL, NULL) != SQLITE_OK)
-			{
-				ThrowError(db.connection.pDb);
-			}
-			});
-		db.UpdateSchema();
+		db.ReconcileSchema();
+		return db;
+	}
+
+	template<class... Ts>
+	[[nodiscard]] Database<Ts...> MakeDatabase(std::string dir, const DatabaseOptions& options, Ts&&... tables)
+	{
+		Database<Ts...> db{ std::move(dir), std::forward<Ts>(tables)... };
+		if (options.autoVacuum)
+		{
+			std::string sql = "PRAGMA auto_vacuum = " + std::to_string(static_cast<int>(*options.autoVacuum)) + ";";
+			ExecMaintenance(db.connection.pDb, sql.c_str());
+		}
+		db.ReconcileSchema();
 		return db;
 	}
 
@@ -305,6 +1096,19 @@ namespace BrilliantDB
 		return { std::move(name), std::make_tuple(cols...) };
 	}
 
+	template<class P, class... Cs>
+	[[nodiscard]] Table<P, Cs...> MakeTable(std::string name, std::vector<TableOption> options, Cs... cols)
+	{
+		return { std::move(name), std::make_tuple(cols...), std::move(options) };
+	}
+
+	//the content table T must be listed before its full-text index in MakeDatabase
+	template<class T, class... Us>
+	[[nodiscard]] FtsTable<T, Us T::*...> MakeFtsTable(std::string name, Us T::*... cols)
+	{
+		return { std::move(name), std::make_tuple(cols...) };
+	}
+
 	template <class O, class F, class... Cs>
 	[[nodiscard]] Column<O, F, Cs...> MakeColumn(std::string name, F O::* ptr, Cs... args)
 	{
@@ -0,0 +1,173 @@
+#pragma once
+
+#include <atomic>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "BrilliantDB.h"
+
+namespace BrilliantDB
+{
+	//spreads rows of every table across N databases with identical schemas
+	//keys handed out are global: local rowid * N + shard index, so point operations route by key modulo N
+	//predicates given to the fan-out operations see local keys and foreign keys aren't enforced across shards
+	//a Database isn't safe to share between threads (last insert rowid, change counts, caches and stats are per connection),
+	//so every call locks the shards it touches and the members can be called from several threads
+	template<class... Ts>
+	struct ShardedDatabase
+	{
+		using ShardType = Database<Ts...>;
+
+		explicit ShardedDatabase(std::vector<std::unique_ptr<ShardType>> shards) : vShards(std::move(shards)), pLocks(std::make_unique<std::mutex[]>(vShards.size())) {}
+
+		template<class T> primary_key_t Insert(const T& t) const;
+		template<class T> std::optional<T> Get(primary_key_t k) const;
+		template<class T> void Update(const T& t) const;
+		template<class T> void Remove(const T& t) const;
+		template<class T, class... Us> std::vector<T> GetAll(Us&&... args) const;
+		template<class T, class... Us> void UpdateAll(Us&&... args) const;
+		template<class T, class... Us> void RemoveAll(Us&&... args) const;
+
+		//runs f(shard, index) on every shard in parallel and returns the results in shard order, use for aggregates
+		//each call holds that shard's lock, so f must not call back into this object
+		template<class F> auto FanOut(F&& f) const;
+
+		std::size_t ShardCount() const { return vShards.size(); }
+		//bypasses the lock, only for use while no other thread is calling into this object
+		const ShardType& Shard(std::size_t i) const { return *vShards[i]; }
+
+		std::vector<std::unique_ptr<ShardType>> vShards;
+		mutable std::atomic<std::size_t> iNextShard = 0;
+
+	private:
+		template<class F>
+		decltype(auto) WithShard(std::size_t i, F&& f) const
+		{
+			std::lock_guard lock(pLocks[i]);
+			return f(*vShards[i]);
+		}
+
+		std::unique_ptr<std::mutex[]> pLocks;
+
+		template<class T> auto KeyMember() const { return vShards.front()->template GetTable<T>().template GetColumn<primary_key_t>().pMember; }
+		sqlite3_int64 ToGlobal(sqlite3_int64 iLocal, std::size_t iShard) const { return iLocal * static_cast<sqlite3_int64>(vShards.size()) + iShard; }
+		//keys handed out are never negative, the default key of an object that wasn't inserted is -1
+		static void RequireKey(sqlite3_int64 iGlobal) noexcept(false) { if (iGlobal < 0) { throw std::runtime_error("sharded key is negative, the object was never inserted"); } }
+		std::size_t ShardOf(sqlite3_int64 iGlobal) const { return static_cast<std::size_t>(iGlobal % static_cast<sqlite3_int64>(vShards.size())); }
+		sqlite3_int64 ToLocal(sqlite3_int64 iGlobal) const { return iGlobal / static_cast<sqlite3_int64>(vShards.size()); }
+	};
+
+	template<class... Ts>
+	template<class T>
+	primary_key_t ShardedDatabase<Ts...>::Insert(const T& t) const
+	{
+		auto iShard = iNextShard++ % vShards.size();
+		primary_key_t k = WithShard(iShard, [&](const ShardType& shard) { return shard.Insert(t); });
+		return ToGlobal(k._t, iShard);
+	}
+
+	template<class... Ts>
+	template<class T>
+	std::optional<T> ShardedDatabase<Ts...>::Get(primary_key_t k) const
+	{
+		if (k._t < 0) { return std::nullopt; }
+		auto iShard = ShardOf(k._t);
+		auto obj = WithShard(iShard, [&](const ShardType& shard) { return shard.template Get<T>(primary_key_t(ToLocal(k._t))); });
+		if (obj) { (*obj).*KeyMember<T>() = k; }
+		return obj;
+	}
+
+	template<class... Ts>
+	template<class T>
+	void ShardedDatabase<Ts...>::Update(const T& t) const
+	{
+		auto p = KeyMember<T>();
+		RequireKey((t.*p)._t);
+		T local = t;
+		local.*p = ToLocal((t.*p)._t);
+		WithShard(ShardOf((t.*p)._t), [&](const ShardType& shard) { shard.Update(local); });
+	}
+
+	template<class... Ts>
+	template<class T>
+	void ShardedDatabase<Ts...>::Remove(const T& t) const
+	{
+		auto p = KeyMember<T>();
+		RequireKey((t.*p)._t);
+		T local = t;
+		local.*p = ToLocal((t.*p)._t);
+		WithShard(ShardOf((t.*p)._t), [&](const ShardType& shard) { shard.Remove(local); });
+	}
+
+	template<class... Ts>
+	template<class F>
+	auto ShardedDatabase<Ts...>::FanOut(F&& f) const
+	{
+		using ResultType = decltype(f(*vShards.front(), std::size_t{}));
+		std::vector<std::future<ResultType>> vFutures;
+		for (std::size_t i = 0; i < vShards.size(); i++)
+		{
+			vFutures.push_back(std::async(std::launch::async, [&f, this, i]() { return WithShard(i, [&](const ShardType& shard) { return f(shard, i); }); }));
+		}
+
+		if constexpr (std::is_void_v<ResultType>)
+		{
+			for (auto& future : vFutures) { future.get(); }
+		}
+		else
+		{
+			std::vector<ResultType> vRet;
+			for (auto& future : vFutures) { vRet.push_back(future.get()); }
+			return vRet;
+		}
+	}
+
+	template<class... Ts>
+	template<class T, class... Us>
+	std::vector<T> ShardedDatabase<Ts...>::GetAll(Us&&... args) const
+	{
+		auto p = KeyMember<T>();
+		auto vParts = FanOut([&](const ShardType& shard, std::size_t iShard) {
+			auto v = shard.template GetAll<T>(args...);
+			for (auto& obj : v) { obj.*p = ToGlobal((obj.*p)._t, iShard); }
+			return v;
+			});
+
+		std::vector<T> vRet;
+		for (auto& v : vParts)
+		{
+			vRet.insert(vRet.end(), std::make_move_iterator(v.begin()), std::make_move_iterator(v.end()));
+		}
+		return vRet;
+	}
+
+	template<class... Ts>
+	template<class T, class... Us>
+	void ShardedDatabase<Ts...>::UpdateAll(Us&&... args) const
+	{
+		FanOut([&](const ShardType& shard, std::size_t) { shard.template UpdateAll<T>(args...); });
+	}
+
+	template<class... Ts>
+	template<class T, class... Us>
+	void ShardedDatabase<Ts...>::RemoveAll(Us&&... args) const
+	{
+		FanOut([&](const ShardType& shard, std::size_t) { shard.template RemoveAll<T>(args...); });
+	}
+
+	template<class... Ts>
+	[[nodiscard]] ShardedDatabase<Ts...> MakeShardedDatabase(const std::vector<std::string>& vFiles, Ts... tables)
+	{
+		std::vector<std::unique_ptr<Database<Ts...>>> vShards;
+		for (const auto& sFile : vFiles)
+		{
+			vShards.push_back(std::make_unique<Database<Ts...>>(MakeDatabase(sFile, Ts(tables)...)));
+		}
+		return ShardedDatabase<Ts...>(std::move(vShards));
+	}
+}
\ No newline at end of file
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <functional>
+#include <sqlite3.h>
+#include "detail/SqliteError.h"
+
+namespace BrilliantDB
+{
+	//called after every backup step with the number of pages left and the total page count
+	using BackupProgress = std::function<void(int iRemaining, int iTotal)>;
+
+	struct BackupOptions
+	{
+		int iPagesPerStep = 256; //-1 copies everything in one step
+		int iSleepMs = 0; //time given to other connections between steps
+		BackupProgress progress;
+	};
+
+	//copies the main database of pFrom over the main database of pTo, errors are reported on pTo
+	inline void Backup(sqlite3* pFrom, sqlite3* pTo, const BackupOptions& options) noexcept(false)
+	{
+		sqlite3_backup* pBackup = sqlite3_backup_init(pTo, "main", pFrom, "main");
+		if (!pBackup)
+		{
+			ThrowError(pTo);
+		}
+
+		int rc = SQLITE_OK;
+		do
+		{
+			rc = sqlite3_backup_step(pBackup, options.iPagesPerStep);
+			if (options.progress)
+			{
+				options.progress(sqlite3_backup_remaining(pBackup), sqlite3_backup_pagecount(pBackup));
+			}
+			if (rc == SQLITE_OK || rc == SQLITE_BUSY || rc == SQLITE_LOCKED)
+			{
+				sqlite3_sleep(options.iSleepMs);
+			}
+		} while (rc == SQLITE_OK || rc == SQLITE_BUSY || rc == SQLITE_LOCKED);
+
+		if (sqlite3_backup_finish(pBackup) != SQLITE_OK || rc != SQLITE_DONE)
+		{
+			ThrowError(pTo);
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,116 @@
+#pragma once
+
+#include <algorithm>
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <sqlite3.h>
+#include "detail/SqliteError.h"
+
+namespace BrilliantDB
+{
+	//reserves iSize zero bytes for a blob column on insert so it can be filled through a BlobHandle
+	template<class T>
+	struct ZeroBlob
+	{
+		std::vector<char> T::* pMember;
+		sqlite3_uint64 iSize;
+	};
+
+	//incremental access to a single blob value, reads and writes never change the blob size
+	struct BlobHandle
+	{
+		BlobHandle(sqlite3* db, const std::string& sTable, const std::string& sColumn, sqlite3_int64 iRow, bool bWrite) noexcept(false) : pDb(db)
+		{
+			if (sqlite3_blob_open(pDb, "main", sTable.c_str(), sColumn.c_str(), iRow, bWrite ? 1 : 0, &pBlob) != SQLITE_OK)
+			{
+				ThrowError(pDb);
+			}
+		}
+
+		~BlobHandle()
+		{
+			sqlite3_blob_close(pBlob);
+		}
+
+		BlobHandle(const BlobHandle& other) = delete;
+		BlobHandle(BlobHandle&& other) noexcept : pDb(other.pDb), pBlob(other.pBlob)
+		{
+			other.pBlob = nullptr;
+		}
+
+		BlobHandle& operator= (const BlobHandle& other) = delete;
+		BlobHandle& operator= (BlobHandle&& other) = delete;
+
+		int Size() const { return sqlite3_blob_bytes(pBlob); }
+
+		//points the handle at the same column of another row without reallocating it
+		void Reopen(sqlite3_int64 iRow) noexcept(false)
+		{
+			if (sqlite3_blob_reopen(pBlob, iRow) != SQLITE_OK)
+			{
+				ThrowError(pDb);
+			}
+		}
+
+		void Read(char* pBuffer, int iSize, int iOffset) const noexcept(false)
+		{
+			if (sqlite3_blob_read(pBlob, pBuffer, iSize, iOffset) != SQLITE_OK)
+			{
+				ThrowError(pDb);
+			}
+		}
+
+		void Write(const char* pBuffer, int iSize, int iOffset) noexcept(false)
+		{
+			if (sqlite3_blob_write(pBlob, pBuffer, iSize, iOffset) != SQLITE_OK)
+			{
+				ThrowError(pDb);
+			}
+		}
+
+		//streams the whole blob into os using a buffer of at most iChunk bytes
+		void ReadTo(std::ostream& os, int iChunk = 64 * 1024) const noexcept(false)
+		{
+			RequireChunk(iChunk);
+			std::vector<char> vBuffer(iChunk);
+			const int iSize = Size();
+			for (int iOffset = 0; iOffset < iSize; iOffset += iChunk)
+			{
+				int n = std::min(iChunk, iSize - iOffset);
+				Read(vBuffer.data(), n, iOffset);
+				os.write(vBuffer.data(), n);
+			}
+		}
+
+		//fills the blob from is using a buffer of at most iChunk bytes, returns the number of bytes written
+		int WriteFrom(std::istream& is, int iChunk = 64 * 1024) noexcept(false)
+		{
+			RequireChunk(iChunk);
+			std::vector<char> vBuffer(iChunk);
+			const int iSize = Size();
+			int iOffset = 0;
+			while (iOffset < iSize && is)
+			{
+				is.read(vBuffer.data(), std::min(iChunk, iSize - iOffset));
+				int n = static_cast<int>(is.gcount());
+				if (!n) { break; }
+				Write(vBuffer.data(), n, iOffset);
+				iOffset += n;
+			}
+			return iOffset;
+		}
+
+		sqlite3* pDb = nullptr;
+		sqlite3_blob* pBlob = nullptr;
+
+	private:
+		//a chunk of zero or less would never advance through the blob
+		static void RequireChunk(int iChunk) noexcept(false)
+		{
+			if (iChunk <= 0) { throw std::runtime_error("blob chunk size must be positive"); }
+		}
+	};
+}
\ No newline at end of file
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <random>
+#include <thread>
+#include <sqlite3.h>
+
+namespace BrilliantDB
+{
+	enum class BusyMode
+	{
+		fail, //SQLITE_BUSY is raised at once
+		timeout, //sqlite3_busy_timeout, sqlite's own sleep schedule
+		backoff //jittered exponential backoff with contention metrics
+	};
+
+	struct BusyPolicy
+	{
+		BusyMode mode = BusyMode::backoff;
+		std::chrono::milliseconds timeout{ 5000 }; //total wait on one lock before giving up
+		std::chrono::milliseconds initialDelay{ 1 };
+		std::chrono::milliseconds maxDelay{ 100 };
+	};
+
+	//only gathered in backoff mode
+	struct BusyStats
+	{
+		std::uint64_t iBusyEvents = 0; //times a lock was found held
+		std::uint64_t iRetries = 0;
+		std::uint64_t iTimeouts = 0; //events that ended in SQLITE_BUSY
+		std::chrono::microseconds waited{ 0 };
+	};
+
+	//sqlite3 busy handler, registered with a pointer to itself so it must stay at a fixed address
+	struct BusyHandler
+	{
+		explicit BusyHandler(const BusyPolicy& p) : policy(p), rng(std::random_device{}()) {}
+
+		void Install(sqlite3* pDb)
+		{
+			switch (policy.mode)
+			{
+			case BusyMode::fail:
+				sqlite3_busy_handler(pDb, nullptr, nullptr);
+				break;
+			case BusyMode::timeout:
+				sqlite3_busy_timeout(pDb, static_cast<int>(policy.timeout.count()));
+				break;
+			case BusyMode::backoff:
+				sqlite3_busy_handler(pDb, &BusyHandler::Callback, this);
+				break;
+			}
+		}
+
+		BusyPolicy policy;
+		BusyStats stats;
+
+	private:
+		using clock = std::chrono::steady_clock;
+
+		static int Callback(void* p, int iCount)
+		{
+			return static_cast<BusyHandler*>(p)->Wait(iCount);
+		}
+
+		int Wait(int iCount)
+		{
+			auto now = clock::now();
+			if (iCount == 0)
+			{
+				stats.iBusyEvents++;
+				tStart = now;
+			}
+			auto remaining = policy.timeout - std::chrono::duration_cast<std::chrono::microseconds>(now - tStart);
+			if (remaining.count() <= 0)
+			{
+				stats.iTimeouts++;
+				return 0;
+			}
+
+			//full delay doubles per retry, the sleep is drawn from its upper half so waiting writers spread out
+			std::chrono::microseconds delay = policy.initialDelay;
+			for (int i = 0; i < iCount && delay < policy.maxDelay; i++) { delay *= 2; }
+			delay = std::min<std::chrono::microseconds>(delay, policy.maxDelay);
+			std::uniform_int_distribution<std::int64_t> jitter(delay.count() / 2, std::max<std::int64_t>(delay.count(), 1));
+			auto sleep = std::min(std::chrono::microseconds(jitter(rng)), remaining);
+
+			std::this_thread::sleep_for(sleep);
+			stats.iRetries++;
+			stats.waited += std::chrono::duration_cast<std::chrono::microseconds>(clock::now() - now);
+			return 1;
+		}
+
+		std::minstd_rand rng;
+		clock::time_point tStart;
+	};
+}
\ No newline at end of file
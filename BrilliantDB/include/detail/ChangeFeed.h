@@ -0,0 +1,144 @@
+#pragma once
+
+#include <exception>
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <sqlite3.h>
+#include "detail/KeyTypes.h"
+
+namespace BrilliantDB
+{
+	enum class ChangeType
+	{
+		insert,
+		update,
+		remove
+	};
+
+	template<class T>
+	struct ChangeEvent
+	{
+		ChangeType type;
+		primary_key_t key;
+	};
+
+	//collects row changes through the update hook and releases them only once their transaction commits
+	//sqlite doesn't allow touching the connection from inside the hooks so delivery happens later through Deliver
+	struct ChangeFeed
+	{
+		using Callback = std::function<void(ChangeType, sqlite3_int64)>;
+
+		struct Change
+		{
+			ChangeType type;
+			std::string sTable;
+			sqlite3_int64 iRow;
+		};
+
+		explicit ChangeFeed(sqlite3* db) : pDb(db)
+		{
+			sqlite3_update_hook(pDb, &OnUpdate, this);
+			sqlite3_commit_hook(pDb, &OnCommit, this);
+			sqlite3_rollback_hook(pDb, &OnRollback, this);
+		}
+
+		~ChangeFeed()
+		{
+			sqlite3_update_hook(pDb, nullptr, nullptr);
+			sqlite3_commit_hook(pDb, nullptr, nullptr);
+			sqlite3_rollback_hook(pDb, nullptr, nullptr);
+		}
+
+		ChangeFeed(const ChangeFeed& other) = delete;
+		ChangeFeed& operator= (const ChangeFeed& other) = delete;
+
+		std::size_t Subscribe(const std::string& sTable, Callback f)
+		{
+			mSubscribers[sTable].emplace_back(++iLastId, std::move(f));
+			return iLastId;
+		}
+
+		void Unsubscribe(std::size_t id)
+		{
+			for (auto& [sTable, vCallbacks] : mSubscribers)
+			{
+				std::erase_if(vCallbacks, [id](const auto& p) { return p.first == id; });
+			}
+		}
+
+		//hands committed changes to subscribers, callbacks may use the database
+		//a callback that throws doesn't stop the delivery, the first exception is rethrown once every change has been handed out
+		void Deliver() noexcept(false)
+		{
+			if (bDelivering) { return; }
+			DeliveryScope scope(bDelivering);
+			std::exception_ptr pError;
+			while (!vCommitted.empty())
+			{
+				auto vChanges = std::move(vCommitted);
+				vCommitted.clear();
+				for (const auto& change : vChanges)
+				{
+					auto it = mSubscribers.find(change.sTable);
+					if (it == mSubscribers.end()) { continue; }
+					auto vCallbacks = it->second; //callbacks may subscribe or unsubscribe
+					for (auto& [id, f] : vCallbacks)
+					{
+						try
+						{
+							f(change.type, change.iRow);
+						}
+						catch (...)
+						{
+							if (!pError) { pError = std::current_exception(); }
+						}
+					}
+				}
+			}
+			if (pError) { std::rethrow_exception(pError); }
+		}
+
+		sqlite3* pDb;
+		std::vector<Change> vPending;
+		std::vector<Change> vCommitted;
+		std::unordered_map<std::string, std::vector<std::pair<std::size_t, Callback>>> mSubscribers;
+		std::size_t iLastId = 0;
+		bool bDelivering = false;
+
+	private:
+		//clears bDelivering however Deliver is left, so a failed delivery doesn't stop the later ones
+		struct DeliveryScope
+		{
+			explicit DeliveryScope(bool& b) : bFlag(b) { bFlag = true; }
+			~DeliveryScope() { bFlag = false; }
+			DeliveryScope(const DeliveryScope& other) = delete;
+			DeliveryScope& operator= (const DeliveryScope& other) = delete;
+
+			bool& bFlag;
+		};
+
+		static void OnUpdate(void* p, int op, const char*, const char* table, sqlite3_int64 iRow)
+		{
+			auto& feed = *static_cast<ChangeFeed*>(p);
+			if (!feed.mSubscribers.count(table)) { return; }
+			ChangeType type = op == SQLITE_INSERT ? ChangeType::insert : op == SQLITE_DELETE ? ChangeType::remove : ChangeType::update;
+			feed.vPending.push_back({ type, table, iRow });
+		}
+
+		static int OnCommit(void* p)
+		{
+			auto& feed = *static_cast<ChangeFeed*>(p);
+			feed.vCommitted.insert(feed.vCommitted.end(), feed.vPending.begin(), feed.vPending.end());
+			feed.vPending.clear();
+			return 0;
+		}
+
+		static void OnRollback(void* p)
+		{
+			static_cast<ChangeFeed*>(p)->vPending.clear();
+		}
+	};
+}
\ No newline at end of file
@@ -0,0 +1,184 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdlib>
+#include <mutex>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <sqlite3.h>
+#include "detail/Connection.h"
+#include "detail/SqliteError.h"
+
+namespace BrilliantDB
+{
+	enum class CheckpointMode
+	{
+		passive = SQLITE_CHECKPOINT_PASSIVE, //copies what it can without waiting on readers or writers
+		full = SQLITE_CHECKPOINT_FULL,
+		restart = SQLITE_CHECKPOINT_RESTART, //also waits for readers so the next writer starts the wal from the beginning
+		truncate = SQLITE_CHECKPOINT_TRUNCATE //restart and shrink the wal file to zero bytes
+	};
+
+	struct CheckpointOptions
+	{
+		CheckpointMode mode = CheckpointMode::passive;
+		std::chrono::milliseconds interval{ 1000 }; //0 only checkpoints when the wal passes iWalBytes
+		sqlite3_int64 iWalBytes = 4 * 1024 * 1024; //0 only checkpoints on the interval
+		std::chrono::milliseconds busyTimeout{ 1000 }; //how long restart and truncate wait for readers and writers
+	};
+
+	struct CheckpointResult
+	{
+		int iLogFrames = 0; //frames in the wal when the checkpoint ran
+		int iCheckpointedFrames = 0; //frames copied back into the database, including earlier checkpoints
+		bool bComplete = false; //false when readers or a writer kept it from finishing
+		std::chrono::microseconds duration{ 0 };
+	};
+
+	struct CheckpointStats
+	{
+		std::uint64_t iRuns = 0;
+		std::uint64_t iIncomplete = 0;
+		std::uint64_t iErrors = 0;
+		int iLastError = SQLITE_OK;
+		CheckpointResult last;
+		std::chrono::microseconds totalDuration{ 0 };
+		std::chrono::microseconds maxDuration{ 0 };
+	};
+
+	inline CheckpointResult RunCheckpoint(sqlite3* pDb, CheckpointMode mode) noexcept(false)
+	{
+		CheckpointResult result;
+		auto tStart = std::chrono::steady_clock::now();
+		int rc = sqlite3_wal_checkpoint_v2(pDb, nullptr, static_cast<int>(mode), &result.iLogFrames, &result.iCheckpointedFrames);
+		result.duration = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - tStart);
+		if (rc != SQLITE_OK && rc != SQLITE_BUSY)
+		{
+			ThrowError(pDb);
+		}
+		result.bComplete = rc == SQLITE_OK && result.iLogFrames == result.iCheckpointedFrames;
+		return result;
+	}
+
+	//checkpoints a wal database from a thread and connection of its own
+	//it takes over the foreground connection's wal hook, so commits there only signal it instead of running the automatic checkpoint
+	class Checkpointer
+	{
+	public:
+		Checkpointer(sqlite3* pForeground, const CheckpointOptions& o) noexcept(false) : options(o), pMain(pForeground),
+			connection(sqlite3_db_filename(pForeground, "main"))
+		{
+			sqlite3_busy_timeout(connection.pDb, static_cast<int>(options.busyTimeout.count()));
+			//a fresh connection only notices the wal once it reads the database
+			if (sqlite3_exec(connection.pDb, "PRAGMA journal_mode=WAL;", nullptr, nullptr, nullptr) != SQLITE_OK)
+			{
+				ThrowError(connection.pDb);
+			}
+			if (options.iWalBytes > 0)
+			{
+				int iPageSize = 4096;
+				sqlite3_exec(connection.pDb, "PRAGMA page_size;", [](void* data, int argc, char** argv, char**) -> int {
+					if (argc && argv[0]) { *static_cast<int*>(data) = std::atoi(argv[0]); }
+					return 0;
+					}, &iPageSize, nullptr);
+				iTriggerFrames = static_cast<int>(std::max<sqlite3_int64>(options.iWalBytes / std::max(iPageSize, 512), 1));
+			}
+			sqlite3_wal_hook(pMain, &Checkpointer::WalHook, this);
+			worker = std::thread([this]() { Loop(); });
+		}
+
+		~Checkpointer()
+		{
+			sqlite3_wal_autocheckpoint(pMain, 1000); //puts back sqlite's default automatic checkpoint in place of our hook
+			{
+				std::lock_guard lock(mutex);
+				bStop = true;
+			}
+			cv.notify_one();
+			worker.join();
+		}
+
+		Checkpointer(const Checkpointer& other) = delete;
+		Checkpointer& operator= (const Checkpointer& other) = delete;
+
+		//runs one checkpoint on the checkpointer's connection from the calling thread
+		CheckpointResult Run(CheckpointMode mode) noexcept(false)
+		{
+			try
+			{
+				auto result = RunCheckpoint(connection.pDb, mode);
+				std::lock_guard lock(mutex);
+				stats.iRuns++;
+				if (!result.bComplete) { stats.iIncomplete++; }
+				stats.last = result;
+				stats.totalDuration += result.duration;
+				stats.maxDuration = std::max(stats.maxDuration, result.duration);
+				return result;
+			}
+			catch (const std::system_error& e)
+			{
+				std::lock_guard lock(mutex);
+				stats.iErrors++;
+				stats.iLastError = e.code().value();
+				throw;
+			}
+		}
+
+		CheckpointStats Stats() const
+		{
+			std::lock_guard lock(mutex);
+			return stats;
+		}
+
+		const CheckpointOptions options;
+
+	private:
+		//called on the writer's thread after each commit, so it only wakes the worker
+		static int WalHook(void* p, sqlite3*, const char*, int iFrames)
+		{
+			auto& self = *static_cast<Checkpointer*>(p);
+			if (self.iTriggerFrames && iFrames >= self.iTriggerFrames)
+			{
+				{
+					std::lock_guard lock(self.mutex);
+					self.bTriggered = true;
+				}
+				self.cv.notify_one();
+			}
+			return SQLITE_OK;
+		}
+
+		void Loop()
+		{
+			std::unique_lock lock(mutex);
+			while (!bStop)
+			{
+				auto Ready = [this]() { return bStop || bTriggered; };
+				if (options.interval.count() > 0) { cv.wait_for(lock, options.interval, Ready); }
+				else { cv.wait(lock, Ready); }
+				if (bStop) { break; }
+				bTriggered = false;
+
+				lock.unlock();
+				try { Run(options.mode); }
+				catch (const std::system_error&) {} //counted in stats, the next round retries
+				lock.lock();
+			}
+		}
+
+		sqlite3* pMain;
+		Connection connection;
+		int iTriggerFrames = 0;
+
+		mutable std::mutex mutex;
+		std::condition_variable cv;
+		bool bStop = false;
+		bool bTriggered = false;
+		CheckpointStats stats;
+		std::thread worker;
+	};
+}
\ No newline at end of file
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <concepts>
+#include <type_traits>
+#include "detail/KeyTypes.h"
+#include "detail/Statement.h"
+
+namespace BrilliantDB
+{
+	//extension point for custom member types, specialize with
+	//	using StorageType = <a supported column type>;
+	//	static StorageType ToStorage(const T&);
+	//	static T FromStorage(StorageType);
+	template<class T>
+	struct ColumnTraits;
+
+	template<class T>
+	concept CustomColumnType = requires { typename ColumnTraits<std::decay_t<T>>::StorageType; };
+
+	template<class T>
+	struct is_key : std::false_type {};
+
+	template<class T, Key K>
+	struct is_key<key_t<T, K>> : std::true_type {};
+
+	//trivially copyable structs and std::arrays are stored as their object representation in a blob
+	//padding bytes go into the blob as well, so equal values can compare unequal in sql and the layout has to match on every platform reading the file
+	template<class T>
+	concept RawBlobType = std::is_trivially_copyable_v<std::decay_t<T>> && std::is_class_v<std::decay_t<T>> &&
+		!is_key<std::decay_t<T>>::value && !ColStatement<T> && !CustomColumnType<T>;
+}
\ No newline at end of file
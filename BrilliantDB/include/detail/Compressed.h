@@ -0,0 +1,206 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#ifdef BRILLIANTDB_ZLIB
+#include <zlib.h>
+#endif
+
+namespace BrilliantDB
+{
+	//byte oriented LZ77 codec, no dependencies and fast enough to run on every bind
+	struct LzCodec
+	{
+		static std::vector<char> Compress(const char* pSrc, std::size_t iSize)
+		{
+			std::vector<char> vOut;
+			vOut.reserve(iSize / 2 + 16);
+			//kept per thread and never cleared, a position left by an earlier call is only a worse candidate since every match is verified
+			thread_local std::vector<std::int64_t> vTable(1 << iHashBits, -1);
+
+			std::size_t i = 0, iAnchor = 0;
+			while (i + iMinMatch <= iSize)
+			{
+				auto h = Hash(pSrc + i);
+				auto iCandidate = vTable[h];
+				vTable[h] = static_cast<std::int64_t>(i);
+				if (iCandidate >= 0 && static_cast<std::size_t>(iCandidate) < i && i - iCandidate <= iMaxOffset && !std::memcmp(pSrc + iCandidate, pSrc + i, iMinMatch))
+				{
+					std::size_t iLen = iMinMatch;
+					while (i + iLen < iSize && pSrc[iCandidate + iLen] == pSrc[i + iLen]) { iLen++; }
+
+					PutVarint(vOut, i - iAnchor);
+					vOut.insert(vOut.end(), pSrc + iAnchor, pSrc + i);
+					PutVarint(vOut, iLen);
+					PutVarint(vOut, i - iCandidate);
+					i += iLen;
+					iAnchor = i;
+				}
+				else
+				{
+					i++;
+				}
+			}
+			PutVarint(vOut, iSize - iAnchor);
+			vOut.insert(vOut.end(), pSrc + iAnchor, pSrc + iSize);
+			PutVarint(vOut, 0);
+			return vOut;
+		}
+
+		static std::vector<char> Decompress(const char* pSrc, std::size_t iSize, std::size_t iOriginal)
+		{
+			std::vector<char> vOut;
+			vOut.reserve(std::min(iOriginal, iSize * 256)); //the stored size isn't trusted yet, a corrupt one could ask for any amount
+			const char* pEnd = pSrc + iSize;
+			while (pSrc < pEnd)
+			{
+				auto iLiterals = GetVarint(pSrc, pEnd);
+				if (iLiterals > static_cast<std::size_t>(pEnd - pSrc) || iLiterals > iOriginal - vOut.size()) { throw std::runtime_error("corrupt compressed value"); }
+				vOut.insert(vOut.end(), pSrc, pSrc + iLiterals);
+				pSrc += iLiterals;
+
+				auto iLen = GetVarint(pSrc, pEnd);
+				if (!iLen) { break; }
+				auto iOffset = GetVarint(pSrc, pEnd);
+				if (!iOffset || iOffset > vOut.size() || iLen > iOriginal - vOut.size()) { throw std::runtime_error("corrupt compressed value"); }
+				std::size_t iFrom = vOut.size() - iOffset;
+				for (std::size_t k = 0; k < iLen; k++) { vOut.push_back(vOut[iFrom + k]); } //matches may overlap their output
+			}
+			if (vOut.size() != iOriginal) { throw std::runtime_error("corrupt compressed value"); }
+			return vOut;
+		}
+
+	private:
+		static constexpr std::size_t iMinMatch = 4;
+		static constexpr std::size_t iMaxOffset = 1 << 16;
+		static constexpr int iHashBits = 14;
+
+		static std::uint32_t Hash(const char* p)
+		{
+			std::uint32_t v;
+			std::memcpy(&v, p, sizeof(v));
+			return (v * 2654435761u) >> (32 - iHashBits);
+		}
+
+		static void PutVarint(std::vector<char>& v, std::size_t n)
+		{
+			while (n >= 0x80)
+			{
+				v.push_back(static_cast<char>((n & 0x7f) | 0x80));
+				n >>= 7;
+			}
+			v.push_back(static_cast<char>(n));
+		}
+
+		static std::size_t GetVarint(const char*& p, const char* pEnd)
+		{
+			std::size_t n = 0;
+			for (int iShift = 0; p < pEnd; iShift += 7)
+			{
+				auto c = static_cast<unsigned char>(*p++);
+				n |= static_cast<std::size_t>(c & 0x7f) << iShift;
+				if (!(c & 0x80)) { return n; }
+			}
+			throw std::runtime_error("corrupt compressed value");
+		}
+	};
+
+#ifdef BRILLIANTDB_ZLIB
+	struct ZlibCodec
+	{
+		static std::vector<char> Compress(const char* pSrc, std::size_t iSize)
+		{
+			uLongf iOut = compressBound(static_cast<uLong>(iSize));
+			std::vector<char> vOut(iOut);
+			if (compress(reinterpret_cast<Bytef*>(vOut.data()), &iOut, reinterpret_cast<const Bytef*>(pSrc), static_cast<uLong>(iSize)) != Z_OK)
+			{
+				throw std::runtime_error("zlib compression failed");
+			}
+			vOut.resize(iOut);
+			return vOut;
+		}
+
+		static std::vector<char> Decompress(const char* pSrc, std::size_t iSize, std::size_t iOriginal)
+		{
+			//deflate can't shrink data by more than about 1032:1, a larger stored size is corrupt and mustn't be allocated
+			if (iOriginal / 1032 > iSize) { throw std::runtime_error("corrupt compressed value"); }
+			uLongf iOut = static_cast<uLongf>(iOriginal);
+			std::vector<char> vOut(iOriginal);
+			if (uncompress(reinterpret_cast<Bytef*>(vOut.data()), &iOut, reinterpret_cast<const Bytef*>(pSrc), static_cast<uLong>(iSize)) != Z_OK || iOut != iOriginal)
+			{
+				throw std::runtime_error("corrupt compressed value");
+			}
+			return vOut;
+		}
+	};
+#endif
+
+	//std::string or std::vector<char> member stored as a compressed blob, values under iThreshold bytes are stored raw
+	template<class T, class Codec = LzCodec, std::size_t iThreshold = 128>
+	struct Compressed
+	{
+		static_assert(std::is_same_v<T, std::string> || std::is_same_v<T, std::vector<char>>, "Compressed supports std::string and std::vector<char>");
+
+		using ValueType = T;
+		using CodecType = Codec;
+
+		operator const T& () const { return value; }
+
+		//stored layout: one flag byte, then either the raw bytes or an 8 byte original size and the codec output
+		std::vector<char> Encode() const
+		{
+			std::vector<char> vOut;
+			if (value.size() >= iThreshold)
+			{
+				auto vPacked = Codec::Compress(value.data(), value.size());
+				if (vPacked.size() + 9 < value.size())
+				{
+					vOut.reserve(vPacked.size() + 9);
+					vOut.push_back(1);
+					std::uint64_t iSize = value.size();
+					for (int i = 0; i < 8; i++) { vOut.push_back(static_cast<char>((iSize >> (8 * i)) & 0xff)); }
+					vOut.insert(vOut.end(), vPacked.begin(), vPacked.end());
+					return vOut;
+				}
+			}
+			vOut.reserve(value.size() + 1);
+			vOut.push_back(0);
+			vOut.insert(vOut.end(), value.begin(), value.end());
+			return vOut;
+		}
+
+		void Decode(const char* pSrc, std::size_t iSize)
+		{
+			if (!iSize)
+			{
+				value = T();
+			}
+			else if (!pSrc[0])
+			{
+				value = T(pSrc + 1, pSrc + iSize);
+			}
+			else
+			{
+				if (iSize < 9) { throw std::runtime_error("corrupt compressed value"); }
+				std::uint64_t iOriginal = 0;
+				for (int i = 0; i < 8; i++) { iOriginal |= static_cast<std::uint64_t>(static_cast<unsigned char>(pSrc[1 + i])) << (8 * i); }
+				auto vRaw = Codec::Decompress(pSrc + 9, iSize - 9, static_cast<std::size_t>(iOriginal));
+				value = T(vRaw.begin(), vRaw.end());
+			}
+		}
+
+		T value;
+	};
+
+	template<class T>
+	struct is_compressed : std::false_type {};
+
+	template<class T, class Codec, std::size_t N>
+	struct is_compressed<Compressed<T, Codec, N>> : std::true_type {};
+}
\ No newline at end of file
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <atomic>
+#include <cstddef>
 #include <fstream>
 #include <string>
 #include <sqlite3.h>
@@ -9,14 +11,16 @@ namespace BrilliantDB
 {
 	struct Connection
 	{
-		Connection(std::string sDir) : sDirectory(std::move(sDir)) { Open(); }
+		//sDir may also be ":memory:" or a uri such as "file:name?mode=memory&cache=shared"
+		Connection(std::string sDir, int flags = SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE | SQLITE_OPEN_URI) :
+			sDirectory(std::move(sDir)), iFlags(flags) { Open(); }
 		~Connection() 
 		{ 
 			Close();
 		}
 
 		Connection(const Connection& other) = delete;
-		Connection(Connection&& other) noexcept : pDb(other.pDb), sDirectory(other.sDirectory)
+		Connection(Connection&& other) noexcept : pDb(other.pDb), sDirectory(other.sDirectory), iFlags(other.iFlags)
 		{
 			other.pDb = nullptr;
 		}
@@ -30,24 +34,38 @@ namespace BrilliantDB
 		void Open() noexcept(false);
 		void Close() noexcept(false);
 
+		//connections opened through this struct and not closed yet, process wide
+		static std::size_t OpenCount() { return s_iOpen.load(); }
+
 		sqlite3* pDb = nullptr;
 		const std::string sDirectory;
+		const int iFlags;
+
+	private:
+		inline static std::atomic<std::size_t> s_iOpen = 0;
 	};
 
 	void Connection::Open() noexcept(false)
 	{
-		if (sqlite3_open(sDirectory.c_str(), &pDb) != SQLITE_OK)
+		if (sqlite3_open_v2(sDirectory.c_str(), &pDb, iFlags, nullptr) != SQLITE_OK)
 		{
-			ThrowError(pDb);
+			//sqlite hands out a handle even when opening fails, it has to be closed after reading the error
+			std::system_error error(sqlite3_errcode(pDb), SqliteCategory(), sqlite3_errmsg(pDb));
+			sqlite3_close(pDb);
+			pDb = nullptr;
+			throw error;
 		}
+		s_iOpen++;
 	}
 
 	void Connection::Close() noexcept(false)
 	{
+		if (!pDb) { return; }
 		if (sqlite3_close(pDb) != SQLITE_OK)
 		{
 			ThrowError(pDb);
 		}
 		pDb = nullptr;
+		s_iOpen--;
 	}
 }
\ No newline at end of file
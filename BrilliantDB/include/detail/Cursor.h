@@ -0,0 +1,41 @@
+#pragma once
+
+#include <optional>
+#include "detail/PreparedStatement.h"
+
+namespace BrilliantDB
+{
+	//steps a prepared select one row at a time, finalizes the statement on destruction if it owns it
+	template<class D, class S>
+	struct Cursor
+	{
+		using ValueType = typename S::TableType;
+
+		Cursor(const D& d, PreparedStatement<S> s, bool owner) : db(d), stmt(s), bOwner(owner) {}
+		~Cursor()
+		{
+			if (bOwner)
+			{
+				sqlite3_finalize(stmt.pStmt);
+			}
+		}
+
+		Cursor(const Cursor& other) = delete;
+		Cursor(Cursor&& other) noexcept : db(other.db), stmt(other.stmt), bOwner(other.bOwner)
+		{
+			other.bOwner = false;
+		}
+
+		Cursor& operator= (const Cursor& other) = delete;
+		Cursor& operator= (Cursor&& other) = delete;
+
+		std::optional<ValueType> Next() noexcept(false)
+		{
+			return db.Execute(stmt);
+		}
+
+		const D& db;
+		PreparedStatement<S> stmt;
+		bool bOwner;
+	};
+}
\ No newline at end of file
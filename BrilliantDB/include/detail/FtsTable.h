@@ -0,0 +1,39 @@
+#pragma once
+
+#include <string>
+#include <tuple>
+#include <vector>
+#include "detail/Table.h"
+
+namespace BrilliantDB
+{
+	//tag used as the PrimaryType of the full-text index over T so it can be looked up with GetTable<Fts<T>>
+	template<class T>
+	struct Fts {};
+
+	//external content fts5 table over text columns of T, kept in sync with T by triggers
+	template<class T, class... Ms>
+	struct FtsTable
+	{
+		FtsTable(std::string name, std::tuple<Ms...> t) : sName(std::move(name)), tCols(std::move(t)) {}
+
+		//mirrors PRAGMA table_info of the virtual table so UpdateSchema finds nothing to alter
+		std::vector<TableInfo> GetTableInfo() const
+		{
+			std::vector<TableInfo> v;
+			for (int i = 0; i < static_cast<int>(sizeof...(Ms)); i++)
+			{
+				TableInfo info;
+				info.iColId = i;
+				v.push_back(info);
+			}
+			return v;
+		}
+
+		std::string sName;
+		std::tuple<Ms...> tCols;
+
+		using PrimaryType = Fts<T>;
+		using ContentType = T;
+	};
+}
\ No newline at end of file
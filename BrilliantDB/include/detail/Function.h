@@ -0,0 +1,121 @@
+#pragma once
+
+#include <exception>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <sqlite3.h>
+
+#include "detail/GeneralConcepts.h"
+#include "detail/KeyTypes.h"
+
+namespace BrilliantDB
+{
+	//same type mapping as RowExtractor but reading function arguments instead of result columns
+	struct ValueExtractor
+	{
+		template<RelativelyLargeInt T>
+		static T Extract(sqlite3_value* v) { return static_cast<T>(sqlite3_value_int64(v)); }
+
+		template<RelativelySmallInt T>
+		static T Extract(sqlite3_value* v) { return static_cast<T>(sqlite3_value_int(v)); }
+
+		template<std::floating_point T>
+		static T Extract(sqlite3_value* v) { return static_cast<T>(sqlite3_value_double(v)); }
+
+		template<PrimaryKeyType T>
+		static T Extract(sqlite3_value* v) { return T(sqlite3_value_int64(v)); }
+
+		template<ForeignKeyType T>
+		static T Extract(sqlite3_value* v) { return T(sqlite3_value_int64(v)); }
+
+		template<class T> requires std::same_as<T, std::string>
+		static std::string Extract(sqlite3_value* v)
+		{
+			auto ret = reinterpret_cast<const char*>(sqlite3_value_text(v));
+			if (ret) { return ret; }
+			return {};
+		}
+
+		template<class T> requires std::same_as<T, std::vector<char>>
+		static std::vector<char> Extract(sqlite3_value* v)
+		{
+			auto buffer = static_cast<const char*>(sqlite3_value_blob(v));
+			std::size_t sz = sqlite3_value_bytes(v);
+			if (sz) { return { buffer, buffer + sz }; }
+			return {};
+		}
+	};
+
+	struct ResultSetter
+	{
+		template<RelativelyLargeInt T>
+		static void Set(sqlite3_context* ctx, T t) { sqlite3_result_int64(ctx, t); }
+
+		template<RelativelySmallInt T>
+		static void Set(sqlite3_context* ctx, T t) { sqlite3_result_int(ctx, t); }
+
+		template<std::floating_point T>
+		static void Set(sqlite3_context* ctx, T t) { sqlite3_result_double(ctx, t); }
+
+		static void Set(sqlite3_context* ctx, const std::string& s) { sqlite3_result_text(ctx, s.c_str(), static_cast<int>(s.size()), SQLITE_TRANSIENT); }
+
+		static void Set(sqlite3_context* ctx, const std::vector<char>& v) { sqlite3_result_blob(ctx, v.data(), static_cast<int>(v.size()), SQLITE_TRANSIENT); }
+	};
+
+	template<class F>
+	struct function_traits : function_traits<decltype(&F::operator())> {};
+
+	template<class R, class... As>
+	struct function_traits<R(*)(As...)>
+	{
+		using ReturnType = R;
+		using ArgTypes = std::tuple<std::decay_t<As>...>;
+	};
+
+	template<class R, class O, class... As>
+	struct function_traits<R(O::*)(As...)> : function_traits<R(*)(As...)> {};
+
+	template<class R, class O, class... As>
+	struct function_traits<R(O::*)(As...) const> : function_traits<R(*)(As...)> {};
+
+	template<class F, std::size_t... Is>
+	auto InvokeWithValues(F& f, sqlite3_value** argv, std::index_sequence<Is...>)
+	{
+		using ArgTypes = typename function_traits<F>::ArgTypes;
+		return f(ValueExtractor::Extract<std::tuple_element_t<Is, ArgTypes>>(argv[Is])...);
+	}
+
+	//sqlite3 xFunc trampoline, the callable is stored as the function's user data
+	template<class F>
+	void InvokeFunction(sqlite3_context* ctx, int argc, sqlite3_value** argv)
+	{
+		constexpr auto iArgs = std::tuple_size_v<typename function_traits<F>::ArgTypes>;
+		if (argc != static_cast<int>(iArgs))
+		{
+			sqlite3_result_error(ctx, "wrong number of arguments to function", -1);
+			return;
+		}
+		auto& f = *static_cast<F*>(sqlite3_user_data(ctx));
+		try
+		{
+			ResultSetter::Set(ctx, InvokeWithValues(f, argv, std::make_index_sequence<iArgs>()));
+		}
+		catch (const std::exception& e)
+		{
+			sqlite3_result_error(ctx, e.what(), -1);
+		}
+		catch (...) //nothing may unwind through sqlite's c frames
+		{
+			sqlite3_result_error(ctx, "function threw a non standard exception", -1);
+		}
+	}
+
+	template<class F>
+	void DestroyFunction(void* p)
+	{
+		delete static_cast<F*>(p);
+	}
+}
\ No newline at end of file
@@ -0,0 +1,156 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <system_error>
+#include <sqlite3.h>
+#include "detail/SqliteError.h"
+
+namespace BrilliantDB
+{
+	//copies share one flag, Cancel can be called from any thread
+	struct CancellationToken
+	{
+		void Cancel() const { pFlag->store(true, std::memory_order_relaxed); }
+		bool Cancelled() const { return pFlag->load(std::memory_order_relaxed); }
+
+		std::shared_ptr<std::atomic<bool>> pFlag = std::make_shared<std::atomic<bool>>(false);
+	};
+
+	//thrown instead of the generic error when a statement was aborted by a token or Database::Interrupt
+	struct QueryCancelled : public std::system_error
+	{
+		explicit QueryCancelled(const char* sWhat = "query cancelled") : std::system_error(SQLITE_INTERRUPT, SqliteCategory(), sWhat) {}
+	};
+
+	struct QueryTimeout : public QueryCancelled
+	{
+		QueryTimeout() : QueryCancelled("query deadline exceeded") {}
+	};
+
+	struct QueryLimit
+	{
+		std::chrono::milliseconds timeout{ 0 }; //0 is no deadline
+		CancellationToken token;
+		int iCheckInterval = 1000; //virtual machine steps between checks
+	};
+
+	enum class InterruptReason
+	{
+		none,
+		cancelled,
+		timeout
+	};
+
+	//state behind the progress handler, an inner watch also checks the ones it replaced
+	//the handler runs on whichever thread steps a statement, a prefetch producer included, so the state it shares is atomic
+	struct QueryWatch
+	{
+		using clock = std::chrono::steady_clock;
+
+		QueryWatch(const QueryLimit& limit, QueryWatch* outer) : token(limit.token), iCheckInterval(limit.iCheckInterval > 0 ? limit.iCheckInterval : 1),
+			bDeadline(limit.timeout.count() > 0), timeout(limit.timeout), deadline(clock::now() + limit.timeout), pOuter(outer) {}
+
+		//called as a statement takes its first step, the deadline and reason belong to one query
+		//a watch held by a live prefetch keeps the deadline that prefetch started with
+		void Arm()
+		{
+			if (iHolds.load(std::memory_order_acquire) == 0)
+			{
+				reason.store(InterruptReason::none, std::memory_order_relaxed);
+				deadline.store(clock::now() + timeout, std::memory_order_relaxed);
+			}
+			if (pOuter) { pOuter->Arm(); }
+		}
+
+		//a prefetch arms the watches once and holds them until its producer has stopped
+		void Hold()
+		{
+			iHolds.fetch_add(1, std::memory_order_acq_rel);
+			if (pOuter) { pOuter->Hold(); }
+		}
+
+		void Release()
+		{
+			iHolds.fetch_sub(1, std::memory_order_acq_rel);
+			if (pOuter) { pOuter->Release(); }
+		}
+
+		InterruptReason Check()
+		{
+			auto r = reason.load(std::memory_order_relaxed);
+			if (r != InterruptReason::none) { return r; }
+			if (token.Cancelled()) { r = InterruptReason::cancelled; }
+			else if (bDeadline && clock::now() >= deadline.load(std::memory_order_relaxed)) { r = InterruptReason::timeout; }
+			else if (pOuter) { r = pOuter->Check(); }
+			if (r != InterruptReason::none) { reason.store(r, std::memory_order_relaxed); }
+			return r;
+		}
+
+		InterruptReason Reason() const { return reason.load(std::memory_order_relaxed); }
+
+		static int Callback(void* p)
+		{
+			return static_cast<QueryWatch*>(p)->Check() != InterruptReason::none;
+		}
+
+		void Install(sqlite3* pDb) { sqlite3_progress_handler(pDb, iCheckInterval, &QueryWatch::Callback, this); }
+
+		CancellationToken token;
+		int iCheckInterval;
+		bool bDeadline;
+		clock::duration timeout;
+		std::atomic<clock::time_point> deadline;
+		QueryWatch* pOuter;
+		std::atomic<InterruptReason> reason = InterruptReason::none;
+		std::atomic<int> iHolds = 0;
+	};
+
+	//keeps a progress handler installed on the connection for its lifetime, statements run meanwhile are aborted once the token is
+	//cancelled or the deadline passes, guards nest and restore the handler they replaced
+	//the timeout applies to each query on its own, counted from the query's first step
+	//a wait inside the busy handler isn't interrupted, keep the busy timeout below the deadline
+	class QueryGuard
+	{
+	public:
+		QueryGuard(sqlite3* db, QueryWatch*& pCurrent, const QueryLimit& limit) : pDb(db), ppCurrent(&pCurrent),
+			pWatch(std::make_unique<QueryWatch>(limit, pCurrent))
+		{
+			pWatch->Install(pDb);
+			pCurrent = pWatch.get();
+		}
+
+		~QueryGuard()
+		{
+			if (!pWatch || *ppCurrent != pWatch.get()) { return; }
+			*ppCurrent = pWatch->pOuter;
+			if (pWatch->pOuter) { pWatch->pOuter->Install(pDb); }
+			else { sqlite3_progress_handler(pDb, 0, nullptr, nullptr); }
+		}
+
+		QueryGuard(const QueryGuard& other) = delete;
+		QueryGuard(QueryGuard&& other) noexcept = default;
+		QueryGuard& operator= (const QueryGuard& other) = delete;
+		QueryGuard& operator= (QueryGuard&& other) = delete;
+
+		//why the latest query was aborted, none once the next one starts
+		InterruptReason Reason() const { return pWatch->Reason(); }
+
+	private:
+		sqlite3* pDb;
+		QueryWatch** ppCurrent;
+		std::unique_ptr<QueryWatch> pWatch;
+	};
+
+	//SQLITE_INTERRUPT only comes from a progress handler or sqlite3_interrupt, so it's always reported as a cancellation
+	inline void ThrowStepError(sqlite3* pDb, const QueryWatch* pWatch)
+	{
+		if (sqlite3_errcode(pDb) == SQLITE_INTERRUPT)
+		{
+			if (pWatch && pWatch->Reason() == InterruptReason::timeout) { throw QueryTimeout(); }
+			throw QueryCancelled();
+		}
+		ThrowError(pDb);
+	}
+}
\ No newline at end of file
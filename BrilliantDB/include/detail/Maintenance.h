@@ -0,0 +1,208 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdlib>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <sqlite3.h>
+#include "detail/Connection.h"
+#include "detail/SqliteError.h"
+
+namespace BrilliantDB
+{
+	enum class AutoVacuum
+	{
+		none = 0,
+		full = 1,
+		incremental = 2 //freed pages stay on the freelist until incremental_vacuum returns them to the file system
+	};
+
+	struct SpaceStats
+	{
+		sqlite3_int64 iPageSize = 0;
+		sqlite3_int64 iPageCount = 0;
+		sqlite3_int64 iFreelistCount = 0; //pages a vacuum could give back
+		AutoVacuum autoVacuum = AutoVacuum::none;
+	};
+
+	inline sqlite3_int64 PragmaValue(sqlite3* pDb, const std::string& sPragma) noexcept(false)
+	{
+		sqlite3_int64 iValue = 0;
+		std::string sql = "PRAGMA " + sPragma + ";";
+		if (sqlite3_exec(pDb, sql.c_str(), [](void* data, int argc, char** argv, char**) -> int {
+				if (argc && argv[0]) { *static_cast<sqlite3_int64*>(data) = std::atoll(argv[0]); }
+				return 0;
+			}, &iValue, nullptr) != SQLITE_OK)
+		{
+			ThrowError(pDb);
+		}
+		return iValue;
+	}
+
+	inline void ExecMaintenance(sqlite3* pDb, const char* sql) noexcept(false)
+	{
+		if (sqlite3_exec(pDb, sql, nullptr, nullptr, nullptr) != SQLITE_OK)
+		{
+			ThrowError(pDb);
+		}
+	}
+
+	inline SpaceStats GetSpaceStats(sqlite3* pDb) noexcept(false)
+	{
+		SpaceStats stats;
+		stats.iPageSize = PragmaValue(pDb, "page_size");
+		stats.iPageCount = PragmaValue(pDb, "page_count");
+		stats.iFreelistCount = PragmaValue(pDb, "freelist_count");
+		stats.autoVacuum = static_cast<AutoVacuum>(PragmaValue(pDb, "auto_vacuum"));
+		return stats;
+	}
+
+	//returns the number of pages given back, at most iPages so a slice holds the write lock for a bounded time
+	inline sqlite3_int64 IncrementalVacuum(sqlite3* pDb, int iPages) noexcept(false)
+	{
+		auto iBefore = PragmaValue(pDb, "freelist_count");
+		PragmaValue(pDb, "incremental_vacuum(" + std::to_string(std::max(iPages, 1)) + ")");
+		return iBefore - PragmaValue(pDb, "freelist_count");
+	}
+
+	struct MaintenanceOptions
+	{
+		std::chrono::milliseconds interval{ 60000 }; //0 runs nothing in the background, only the optimize on close
+		int iVacuumPages = 256; //pages per incremental vacuum slice
+		int iMaxSlices = 16; //slices per round, the write lock is released between them
+		sqlite3_int64 iMinFreePages = 64; //smaller freelists are left alone
+		std::chrono::milliseconds optimizeInterval{ 3600000 }; //0 never optimizes in the background
+		bool bOptimizeOnClose = true;
+		std::chrono::milliseconds busyTimeout{ 1000 };
+	};
+
+	struct MaintenanceStats
+	{
+		std::uint64_t iRuns = 0;
+		std::uint64_t iVacuumSlices = 0;
+		sqlite3_int64 iPagesFreed = 0;
+		std::uint64_t iOptimizeRuns = 0;
+		std::uint64_t iErrors = 0;
+		int iLastError = SQLITE_OK;
+		std::chrono::microseconds lastDuration{ 0 };
+	};
+
+	//reclaims free pages and refreshes planner statistics from a thread and connection of its own, so slices never run on a caller's thread
+	//optimizes on the foreground connection when it is destroyed, which is what sqlite recommends doing before a connection closes
+	class Maintainer
+	{
+	public:
+		Maintainer(sqlite3* pForeground, const MaintenanceOptions& o) noexcept(false) : options(o), pMain(pForeground)
+		{
+			if (options.interval.count() <= 0) { return; }
+			const char* sFile = sqlite3_db_filename(pMain, "main");
+			if (!sFile || !*sFile)
+			{
+				throw std::runtime_error("background maintenance needs a file database");
+			}
+			connection.emplace(sFile);
+			sqlite3_busy_timeout(connection->pDb, static_cast<int>(options.busyTimeout.count()));
+			tLastOptimize = std::chrono::steady_clock::now();
+			worker = std::thread([this]() { Loop(); });
+		}
+
+		~Maintainer()
+		{
+			if (worker.joinable())
+			{
+				{
+					std::lock_guard lock(mutex);
+					bStop = true;
+				}
+				cv.notify_one();
+				worker.join();
+			}
+			if (options.bOptimizeOnClose)
+			{
+				sqlite3_exec(pMain, "PRAGMA optimize;", nullptr, nullptr, nullptr);
+			}
+		}
+
+		Maintainer(const Maintainer& other) = delete;
+		Maintainer& operator= (const Maintainer& other) = delete;
+
+		MaintenanceStats Stats() const
+		{
+			std::lock_guard lock(mutex);
+			return stats;
+		}
+
+		const MaintenanceOptions options;
+
+	private:
+		void RunOnce()
+		{
+			auto tStart = std::chrono::steady_clock::now();
+			sqlite3* pDb = connection->pDb;
+			std::uint64_t iSlices = 0;
+			sqlite3_int64 iFreed = 0;
+			bool bOptimized = false;
+			try
+			{
+				if (static_cast<AutoVacuum>(PragmaValue(pDb, "auto_vacuum")) == AutoVacuum::incremental)
+				{
+					for (int i = 0; i < options.iMaxSlices && PragmaValue(pDb, "freelist_count") >= std::max<sqlite3_int64>(options.iMinFreePages, 1); i++)
+					{
+						auto n = IncrementalVacuum(pDb, options.iVacuumPages);
+						iSlices++;
+						iFreed += n;
+						if (!n) { break; }
+					}
+				}
+				if (options.optimizeInterval.count() > 0 && tStart - tLastOptimize >= options.optimizeInterval)
+				{
+					//0x10002 looks at every table, this connection hasn't run the queries optimize would otherwise go by
+					ExecMaintenance(pDb, "PRAGMA optimize=0x10002;");
+					tLastOptimize = tStart;
+					bOptimized = true;
+				}
+			}
+			catch (const std::system_error& e)
+			{
+				std::lock_guard lock(mutex);
+				stats.iErrors++;
+				stats.iLastError = e.code().value();
+			}
+
+			std::lock_guard lock(mutex);
+			stats.iRuns++;
+			stats.iVacuumSlices += iSlices;
+			stats.iPagesFreed += iFreed;
+			if (bOptimized) { stats.iOptimizeRuns++; }
+			stats.lastDuration = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - tStart);
+		}
+
+		void Loop()
+		{
+			std::unique_lock lock(mutex);
+			while (!cv.wait_for(lock, options.interval, [this]() { return bStop; }))
+			{
+				lock.unlock();
+				RunOnce();
+				lock.lock();
+			}
+		}
+
+		sqlite3* pMain;
+		std::optional<Connection> connection;
+		std::chrono::steady_clock::time_point tLastOptimize;
+
+		mutable std::mutex mutex;
+		std::condition_variable cv;
+		bool bStop = false;
+		MaintenanceStats stats;
+		std::thread worker;
+	};
+}
\ No newline at end of file
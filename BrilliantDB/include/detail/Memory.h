@@ -0,0 +1,275 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <system_error>
+#include <vector>
+#include <sqlite3.h>
+#include "detail/Connection.h"
+#include "detail/SqliteError.h"
+
+namespace BrilliantDB
+{
+	//size-class pool behind SQLITE_CONFIG_MALLOC, small blocks are carved from slabs and recycled through free lists
+	class PoolAllocator
+	{
+	public:
+		static sqlite3_mem_methods Methods(PoolAllocator* pPool)
+		{
+			return { &Malloc, &Free, &Realloc, &Size, &Roundup, &Init, &Shutdown, pPool };
+		}
+
+	private:
+		struct Header
+		{
+			std::uint32_t iClass;
+			std::uint32_t iPad;
+			std::uint64_t iSize; //usable bytes after the header
+		};
+		static_assert(sizeof(Header) == 16, "header keeps blocks 16 byte aligned");
+
+		static constexpr std::uint32_t iNumClasses = 9; //16 bytes to 4 KiB
+		static constexpr std::uint32_t iLarge = iNumClasses;
+		static constexpr std::size_t iSlabSize = 64 * 1024;
+
+		static std::size_t ClassSize(std::uint32_t c) { return std::size_t(16) << c; }
+
+		static std::uint32_t ClassOf(std::size_t n)
+		{
+			std::uint32_t c = 0;
+			while (c < iNumClasses && ClassSize(c) < n) { c++; }
+			return c;
+		}
+
+		static PoolAllocator& Self() { return *s_pActive; }
+
+		static void* Malloc(int n)
+		{
+			if (n <= 0) { return nullptr; }
+			auto c = ClassOf(static_cast<std::size_t>(n));
+			Header* pHeader = nullptr;
+			if (c == iLarge)
+			{
+				pHeader = static_cast<Header*>(std::malloc(sizeof(Header) + n));
+				if (!pHeader) { return nullptr; }
+				pHeader->iSize = static_cast<std::uint64_t>(n);
+			}
+			else
+			{
+				auto& pool = Self();
+				std::lock_guard lock(pool.mutex);
+				auto& vFree = pool.vFreeLists[c];
+				if (vFree.empty() && !pool.Grow(c)) { return nullptr; }
+				pHeader = static_cast<Header*>(vFree.back());
+				vFree.pop_back();
+				pHeader->iSize = ClassSize(c);
+			}
+			pHeader->iClass = c;
+			return pHeader + 1;
+		}
+
+		static void Free(void* p)
+		{
+			if (!p) { return; }
+			auto pHeader = static_cast<Header*>(p) - 1;
+			if (pHeader->iClass == iLarge)
+			{
+				std::free(pHeader);
+				return;
+			}
+			auto& pool = Self();
+			std::lock_guard lock(pool.mutex);
+			pool.vFreeLists[pHeader->iClass].push_back(pHeader);
+		}
+
+		static void* Realloc(void* p, int n)
+		{
+			if (!p) { return Malloc(n); }
+			if (static_cast<std::uint64_t>(n) <= (static_cast<Header*>(p) - 1)->iSize) { return p; }
+			void* pNew = Malloc(n);
+			if (pNew)
+			{
+				std::memcpy(pNew, p, (static_cast<Header*>(p) - 1)->iSize);
+				Free(p);
+			}
+			return pNew;
+		}
+
+		static int Size(void* p)
+		{
+			return p ? static_cast<int>((static_cast<Header*>(p) - 1)->iSize) : 0;
+		}
+
+		static int Roundup(int n)
+		{
+			auto c = ClassOf(static_cast<std::size_t>(n));
+			return c == iLarge ? (n + 7) & ~7 : static_cast<int>(ClassSize(c));
+		}
+
+		static int Init(void* p)
+		{
+			s_pActive = static_cast<PoolAllocator*>(p);
+			return SQLITE_OK;
+		}
+
+		static void Shutdown(void* p)
+		{
+			auto& pool = *static_cast<PoolAllocator*>(p);
+			std::lock_guard lock(pool.mutex);
+			for (auto& vFree : pool.vFreeLists) { vFree.clear(); }
+			pool.vSlabs.clear();
+		}
+
+		bool Grow(std::uint32_t c)
+		{
+			const std::size_t iBlock = sizeof(Header) + ClassSize(c);
+			std::unique_ptr<char[]> pSlab(new (std::nothrow) char[iSlabSize]);
+			if (!pSlab) { return false; }
+			for (std::size_t iOffset = 0; iOffset + iBlock <= iSlabSize; iOffset += iBlock)
+			{
+				vFreeLists[c].push_back(pSlab.get() + iOffset);
+			}
+			vSlabs.push_back(std::move(pSlab));
+			return true;
+		}
+
+		inline static PoolAllocator* s_pActive = nullptr;
+
+		std::mutex mutex;
+		std::array<std::vector<void*>, iNumClasses> vFreeLists;
+		std::vector<std::unique_ptr<char[]>> vSlabs;
+	};
+
+	enum class AllocatorKind
+	{
+		system,
+		pool
+	};
+
+	//process wide settings, apply with ConfigureMemory before any connection is opened
+	struct MemoryConfig
+	{
+		AllocatorKind allocator = AllocatorKind::system;
+		int iPageCacheSlots = 0; //preallocated page cache slots, 0 leaves the page cache on the heap
+		int iPageSize = 4096; //largest page size the arena has to hold
+		int iLookasideSize = -1; //bytes per lookaside slot, -1 uses the sqlite default
+		int iLookasideCount = -1;
+		sqlite3_int64 iSoftHeapLimit = 0; //0 is unlimited
+		sqlite3_int64 iHardHeapLimit = 0;
+	};
+
+	//SQLITE_DEFAULT_LOOKASIDE of a stock build
+	inline constexpr int iDefaultLookasideSize = 1200;
+	inline constexpr int iDefaultLookasideCount = 40;
+
+	inline void ThrowConfigError(int rc, const char* sWhat = "sqlite3_config failed")
+	{
+		throw std::system_error(rc, SqliteCategory(), sWhat);
+	}
+
+	//restarts sqlite with the given allocator and arenas, throws SQLITE_MISUSE while any Connection is open
+	//every setting is applied each time, sqlite keeps its configuration across sqlite3_shutdown
+	inline void ConfigureMemory(const MemoryConfig& config) noexcept(false)
+	{
+		static PoolAllocator pool;
+		static std::unique_ptr<char[]> pPageCache;
+		static std::optional<sqlite3_mem_methods> systemMethods;
+
+		if (Connection::OpenCount())
+		{
+			ThrowConfigError(SQLITE_MISUSE, "memory can't be reconfigured while connections are open");
+		}
+
+		int rc = sqlite3_shutdown();
+		if (rc != SQLITE_OK) { ThrowConfigError(rc); }
+
+		if (!systemMethods)
+		{
+			sqlite3_mem_methods methods{};
+			if ((rc = sqlite3_config(SQLITE_CONFIG_GETMALLOC, &methods)) != SQLITE_OK) { ThrowConfigError(rc); }
+			systemMethods = methods;
+		}
+		sqlite3_mem_methods methods = config.allocator == AllocatorKind::pool ? PoolAllocator::Methods(&pool) : *systemMethods;
+		if ((rc = sqlite3_config(SQLITE_CONFIG_MALLOC, &methods)) != SQLITE_OK) { ThrowConfigError(rc); }
+
+		if (config.iPageCacheSlots > 0)
+		{
+			int iHeader = 0;
+			sqlite3_config(SQLITE_CONFIG_PCACHE_HDRSZ, &iHeader);
+			const int iSlot = ((config.iPageSize + iHeader) + 7) & ~7;
+			pPageCache.reset(new char[static_cast<std::size_t>(iSlot) * config.iPageCacheSlots]);
+			if ((rc = sqlite3_config(SQLITE_CONFIG_PAGECACHE, pPageCache.get(), iSlot, config.iPageCacheSlots)) != SQLITE_OK) { ThrowConfigError(rc); }
+		}
+		else
+		{
+			sqlite3_config(SQLITE_CONFIG_PAGECACHE, nullptr, 0, 0);
+			pPageCache.reset();
+		}
+
+		const bool bLookaside = config.iLookasideSize >= 0 && config.iLookasideCount >= 0;
+		if ((rc = sqlite3_config(SQLITE_CONFIG_LOOKASIDE, bLookaside ? config.iLookasideSize : iDefaultLookasideSize,
+			bLookaside ? config.iLookasideCount : iDefaultLookasideCount)) != SQLITE_OK)
+		{
+			ThrowConfigError(rc);
+		}
+
+		if ((rc = sqlite3_initialize()) != SQLITE_OK) { ThrowConfigError(rc); }
+		sqlite3_hard_heap_limit64(config.iHardHeapLimit); //lowers the soft limit, so it goes first
+		sqlite3_soft_heap_limit64(config.iSoftHeapLimit);
+	}
+
+	struct MemoryStats
+	{
+		sqlite3_int64 iUsed = 0;
+		sqlite3_int64 iHighwater = 0;
+		sqlite3_int64 iPageCacheUsed = 0; //slots of the preallocated arena in use
+		sqlite3_int64 iPageCacheOverflow = 0; //bytes of page cache that didn't fit in the arena
+		sqlite3_int64 iSoftHeapLimit = 0;
+		sqlite3_int64 iHardHeapLimit = 0;
+	};
+
+	inline MemoryStats GetMemoryStats(bool bResetHighwater = false)
+	{
+		MemoryStats stats;
+		sqlite3_int64 iHigh = 0;
+		stats.iUsed = sqlite3_memory_used();
+		stats.iHighwater = sqlite3_memory_highwater(bResetHighwater);
+		sqlite3_status64(SQLITE_STATUS_PAGECACHE_USED, &stats.iPageCacheUsed, &iHigh, bResetHighwater);
+		sqlite3_status64(SQLITE_STATUS_PAGECACHE_OVERFLOW, &stats.iPageCacheOverflow, &iHigh, bResetHighwater);
+		stats.iSoftHeapLimit = sqlite3_soft_heap_limit64(-1);
+		stats.iHardHeapLimit = sqlite3_hard_heap_limit64(-1);
+		return stats;
+	}
+
+	//sqlite3_db_status figures for one connection
+	struct ConnectionMemoryStats
+	{
+		int iCacheUsed = 0; //bytes held by the page cache
+		int iCacheHits = 0;
+		int iCacheMisses = 0;
+		int iCacheWrites = 0;
+		int iLookasideUsed = 0;
+		int iLookasideHighwater = 0;
+		int iSchemaUsed = 0;
+		int iStatementsUsed = 0;
+	};
+
+	inline ConnectionMemoryStats GetConnectionMemoryStats(sqlite3* pDb, bool bReset = false)
+	{
+		ConnectionMemoryStats stats;
+		int iHigh = 0;
+		sqlite3_db_status(pDb, SQLITE_DBSTATUS_CACHE_USED, &stats.iCacheUsed, &iHigh, 0);
+		sqlite3_db_status(pDb, SQLITE_DBSTATUS_CACHE_HIT, &stats.iCacheHits, &iHigh, bReset);
+		sqlite3_db_status(pDb, SQLITE_DBSTATUS_CACHE_MISS, &stats.iCacheMisses, &iHigh, bReset);
+		sqlite3_db_status(pDb, SQLITE_DBSTATUS_CACHE_WRITE, &stats.iCacheWrites, &iHigh, bReset);
+		sqlite3_db_status(pDb, SQLITE_DBSTATUS_LOOKASIDE_USED, &stats.iLookasideUsed, &stats.iLookasideHighwater, bReset);
+		sqlite3_db_status(pDb, SQLITE_DBSTATUS_SCHEMA_USED, &stats.iSchemaUsed, &iHigh, 0);
+		sqlite3_db_status(pDb, SQLITE_DBSTATUS_STMT_USED, &stats.iStatementsUsed, &iHigh, 0);
+		return stats;
+	}
+}
\ No newline at end of file
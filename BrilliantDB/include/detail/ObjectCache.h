@@ -0,0 +1,96 @@
+#pragma once
+
+#include <cstdint>
+#include <list>
+#include <optional>
+#include <unordered_map>
+#include <utility>
+#include <sqlite3.h>
+
+namespace BrilliantDB
+{
+	struct CacheStats
+	{
+		std::uint64_t iHits = 0;
+		std::uint64_t iMisses = 0;
+		std::uint64_t iEvictions = 0;
+	};
+
+	//LRU identity map keyed by primary key, a capacity of 0 disables the cache
+	//not thread safe: even Find reorders the list and counts stats, so a cache must only be used from one thread at a time
+	//Database holds one per table and mutates it from const members, which is one of the reasons a Database can't be shared between threads
+	template<class T>
+	struct ObjectCache
+	{
+		using key_type = sqlite3_int64;
+
+		bool Enabled() const { return iCapacity > 0; }
+
+		void SetCapacity(std::size_t n)
+		{
+			iCapacity = n;
+			Shrink();
+		}
+
+		std::optional<T> Find(key_type k)
+		{
+			auto it = mIndex.find(k);
+			if (it == mIndex.end())
+			{
+				stats.iMisses++;
+				return std::nullopt;
+			}
+			stats.iHits++;
+			lItems.splice(lItems.begin(), lItems, it->second);
+			return it->second->second;
+		}
+
+		void Put(key_type k, const T& t)
+		{
+			if (!Enabled()) { return; }
+			auto it = mIndex.find(k);
+			if (it != mIndex.end())
+			{
+				it->second->second = t;
+				lItems.splice(lItems.begin(), lItems, it->second);
+				return;
+			}
+			lItems.emplace_front(k, t);
+			mIndex.emplace(k, lItems.begin());
+			Shrink();
+		}
+
+		void Erase(key_type k)
+		{
+			auto it = mIndex.find(k);
+			if (it != mIndex.end())
+			{
+				lItems.erase(it->second);
+				mIndex.erase(it);
+			}
+		}
+
+		void Clear()
+		{
+			lItems.clear();
+			mIndex.clear();
+		}
+
+		std::size_t iCapacity = 0;
+		CacheStats stats;
+
+	private:
+		void Shrink()
+		{
+			while (lItems.size() > iCapacity)
+			{
+				mIndex.erase(lItems.back().first);
+				lItems.pop_back();
+				stats.iEvictions++;
+			}
+		}
+
+		std::list<std::pair<key_type, T>> lItems;
+		std::unordered_map<key_type, typename std::list<std::pair<key_type, T>>::iterator> mIndex;
+	};
+}
\ No newline at end of file
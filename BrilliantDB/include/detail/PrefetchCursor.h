@@ -0,0 +1,174 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <memory>
+#include <optional>
+#include <thread>
+#include "detail/Interrupt.h"
+#include "detail/PreparedStatement.h"
+#include "detail/RowExtractor.h"
+
+namespace BrilliantDB
+{
+	//bounded single producer single consumer queue, blocks the producer while full and the consumer while empty
+	template<class T>
+	struct RingBuffer
+	{
+		explicit RingBuffer(std::size_t capacity) : iCapacity(capacity ? capacity : 1), pSlots(std::make_unique<T[]>(iCapacity)) {}
+
+		//returns false without pushing if bStop was raised while waiting for space
+		bool Push(T&& value, const std::atomic<bool>& bStop)
+		{
+			auto t = iTail.load(std::memory_order_relaxed);
+			for (auto h = iHead.load(std::memory_order_acquire); t - h == iCapacity; h = iHead.load(std::memory_order_acquire))
+			{
+				if (bStop.load(std::memory_order_acquire)) { return false; }
+				iHead.wait(h, std::memory_order_acquire);
+			}
+			pSlots[t % iCapacity] = std::move(value);
+			iTail.store(t + 1, std::memory_order_release);
+			iTail.notify_one();
+			return true;
+		}
+
+		T Pop()
+		{
+			auto h = iHead.load(std::memory_order_relaxed);
+			for (auto t = iTail.load(std::memory_order_acquire); t == h; t = iTail.load(std::memory_order_acquire))
+			{
+				iTail.wait(t, std::memory_order_acquire);
+			}
+			T value = std::move(pSlots[h % iCapacity]);
+			pSlots[h % iCapacity] = T();
+			iHead.store(h + 1, std::memory_order_release);
+			iHead.notify_one();
+			return value;
+		}
+
+		bool Empty() const { return iHead.load(std::memory_order_acquire) == iTail.load(std::memory_order_acquire); }
+
+		const std::size_t iCapacity;
+		std::unique_ptr<T[]> pSlots;
+		std::atomic<std::size_t> iHead = 0; //only written by the consumer
+		std::atomic<std::size_t> iTail = 0; //only written by the producer
+	};
+
+	//steps the select and builds rows on a background thread while the caller consumes them
+	//the connection is shared with the producer, so it has to be opened in serialized mode (the sqlite default)
+	//a QueryGuard active when the cursor is made limits the whole prefetch and has to outlive the cursor,
+	//its deadline runs from the cursor's creation and isn't restarted by queries the caller runs meanwhile
+	template<class D, class S>
+	struct PrefetchCursor
+	{
+		using ValueType = typename S::TableType;
+
+		PrefetchCursor(const D& d, PreparedStatement<S> s, bool owner, std::size_t iCapacity = 256) : db(d), stmt(s), bOwner(owner),
+			pWatch(d.pWatch), buffer(iCapacity)
+		{
+			if (pWatch)
+			{
+				pWatch->Arm();
+				pWatch->Hold();
+			}
+			producer = std::thread([this]() { Produce(); });
+		}
+
+		~PrefetchCursor()
+		{
+			Cancel();
+			if (bOwner)
+			{
+				sqlite3_finalize(stmt.pStmt);
+			}
+		}
+
+		PrefetchCursor(const PrefetchCursor& other) = delete;
+		PrefetchCursor(PrefetchCursor&& other) = delete;
+		PrefetchCursor& operator= (const PrefetchCursor& other) = delete;
+		PrefetchCursor& operator= (PrefetchCursor&& other) = delete;
+
+		//rethrows an error raised by the producer once the rows before it have been consumed
+		std::optional<ValueType> Next() noexcept(false)
+		{
+			if (bFinished) { return std::nullopt; }
+			auto obj = buffer.Pop();
+			if (!obj)
+			{
+				bFinished = true;
+				Join();
+				if (pError) { std::rethrow_exception(pError); }
+			}
+			return obj;
+		}
+
+		//stops the producer early and resets the statement so a borrowed one can be run again
+		//a step in progress runs to its next row first, sqlite3_interrupt isn't used since it would abort every statement on the connection
+		void Cancel()
+		{
+			if (!producer.joinable()) { return; }
+			bStop.store(true, std::memory_order_release);
+			if (!buffer.Empty()) { buffer.Pop(); } //frees a slot in case the producer is blocked on a full buffer
+			Join();
+			bFinished = true;
+			sqlite3_reset(stmt.pStmt);
+		}
+
+		const D& db;
+		PreparedStatement<S> stmt;
+		bool bOwner;
+
+	private:
+		//holds the connection's mutex so the error read after a failed step is this statement's and not one from the caller's thread
+		struct ConnectionLock
+		{
+			explicit ConnectionLock(sqlite3* pDb) : pMutex(sqlite3_db_mutex(pDb)) { sqlite3_mutex_enter(pMutex); }
+			~ConnectionLock() { sqlite3_mutex_leave(pMutex); }
+			ConnectionLock(const ConnectionLock& other) = delete;
+			ConnectionLock& operator= (const ConnectionLock& other) = delete;
+
+			sqlite3_mutex* pMutex;
+		};
+
+		void Join()
+		{
+			producer.join();
+			if (pWatch) { pWatch->Release(); }
+		}
+
+		void Produce()
+		{
+			try
+			{
+				while (!bStop.load(std::memory_order_acquire))
+				{
+					int rc;
+					{
+						ConnectionLock lock(db.connection.pDb);
+						rc = sqlite3_step(stmt.pStmt);
+						if (rc != SQLITE_ROW && rc != SQLITE_DONE) { ThrowStepError(db.connection.pDb, pWatch); }
+					}
+					if (rc == SQLITE_DONE)
+					{
+						buffer.Push(std::nullopt, bStop);
+						return;
+					}
+					if (!buffer.Push(Build<ValueType>(stmt, db.template GetTable<ValueType>().tCols), bStop)) { return; }
+				}
+			}
+			catch (...)
+			{
+				pError = std::current_exception();
+				buffer.Push(std::nullopt, bStop);
+			}
+		}
+
+		QueryWatch* pWatch; //taken on the caller's thread, the database's current watch changes as guards come and go
+		RingBuffer<std::optional<ValueType>> buffer;
+		std::atomic<bool> bStop = false;
+		bool bFinished = false;
+		std::exception_ptr pError;
+		std::thread producer;
+	};
+}
\ No newline at end of file
@@ -1,6 +1,8 @@
 #pragma once
 
+#include <algorithm>
 #include <functional>
+#include <memory_resource>
 #include <string>
 #include <sqlite3.h>
 #include "detail/Connection.h"
@@ -10,6 +12,7 @@
 #include "detail/GeneralConcepts.h"
 #include "detail/TupleUtils.h"
 #include "detail/KeyTypes.h"
+#include "detail/ColumnTraits.h"
 
 namespace BrilliantDB
 {
@@ -62,14 +65,51 @@ namespace BrilliantDB
 
 		int Bind(const std::string& s) { return Bind(s.c_str()); }
 
+		int Bind(const std::pmr::string& s) { return Bind(s.c_str()); }
+
 		template<ColStatement T>
 		int Bind(const T& c) { return Bind(c.value); }
 
-		int Bind(const std::vector<char>& v)
+		template<class T, class Tbl>
+		int Bind(const ObjectKey<T, Tbl>& k)
+		{
+			int rc = SQLITE_OK;
+			TupleUtils::for_each_tuple(k.table.tCols, [&](auto& col) {
+				if constexpr (!is_foreign_key<std::decay_t<decltype(col)>>::value)
+				{
+					if (rc == SQLITE_OK && std::find(col.vConstraints.cbegin(), col.vConstraints.cend(), Constraint::primary_key) != col.vConstraints.cend())
+					{
+						rc = Bind(k.obj.*col.pMember);
+					}
+				}
+				});
+			return rc;
+		}
+
+		//the list length is only known at runtime, so every value is bound from the one item
+		template<class T, class U>
+		int Bind(const InC<T, U>& c)
+		{
+			for (const auto& v : c.vValues)
+			{
+				if (int rc = Bind(v); rc != SQLITE_OK) { return rc; }
+			}
+			return SQLITE_OK;
+		}
+
+		//parameters are left unbound until Query::Run but still take up an index
+		template<class T, class U, std::size_t N>
+		int Bind(const PC<T, U, N>&) { iIndex++; return SQLITE_OK; }
+
+		int Bind(const std::vector<char>& v) { return BindBlob(v.data(), v.size()); }
+
+		int Bind(const std::pmr::vector<char>& v) { return BindBlob(v.data(), v.size()); }
+
+		int BindBlob(const char* pData, std::size_t iSize)
 		{
-			if (v.size())
+			if (iSize)
 			{
-				return sqlite3_bind_blob(stmt.pStmt, iIndex++, (const void*)&v.front(), v.size(), SQLITE_TRANSIENT);
+				return sqlite3_bind_blob(stmt.pStmt, iIndex++, pData, iSize, SQLITE_TRANSIENT);
 			}
 			else
 			{
@@ -77,6 +117,20 @@ namespace BrilliantDB
 			}
 		}
 
+		template<class T, class Codec, std::size_t N>
+		int Bind(const Compressed<T, Codec, N>& c)
+		{
+			auto v = c.Encode();
+			return sqlite3_bind_blob(stmt.pStmt, iIndex++, v.data(), static_cast<int>(v.size()), SQLITE_TRANSIENT);
+		}
+
+		//bound straight from the object's memory, sqlite takes its own copy
+		template<RawBlobType T>
+		int Bind(const T& t) { return sqlite3_bind_blob(stmt.pStmt, iIndex++, &t, static_cast<int>(sizeof(T)), SQLITE_TRANSIENT); }
+
+		template<CustomColumnType T>
+		int Bind(const T& t) { return Bind(ColumnTraits<T>::ToStorage(t)); }
+
 		template<class T>
 		void operator() (T&& t)
 		{
@@ -105,6 +159,47 @@ namespace BrilliantDB
 			return TupleUtils::BuildFromOther(*this, TupleUtils::Flatten(t.t));
 		}
 
+		//BETWEEN binds its bounds as two items, IS NULL binds nothing
+		template<class T, class U>
+		auto operator() (const BetweenC<T, U>& t) const
+		{
+			return std::make_tuple(t.low, t.high);
+		}
+
+		template<class T, class U>
+		auto operator() (const NullC<T, U>&) const
+		{
+			return std::tuple<>();
+		}
+
+		template<class... As>
+		auto operator() (const FunctionCall<As...>& t) const
+		{
+			return TupleUtils::BuildFromOther([](const auto& arg)->auto
+				requires (!std::is_member_object_pointer_v<std::decay_t<decltype(arg)>>)
+				{
+					return arg;
+				}, t.tArgs);
+		}
+
+		template<class F, class V>
+		auto operator() (const FunctionCompare<F, V>& t) const
+		{
+			return std::tuple_cat((*this)(t.call), std::make_tuple(t.value));
+		}
+
+		template<class T, class... Ks>
+		auto operator() (const KeyWhereStatement<T, Ks...>& t) const
+		{
+			return t.tKeys;
+		}
+
+		template<class T, class U>
+		auto operator() (const OrderByRankStatement<T, U>& t) const
+		{
+			return std::make_tuple(t.match);
+		}
+
 		template<ColStatement T>
 		auto operator() (const T& t) const
 		{
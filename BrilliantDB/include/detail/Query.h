@@ -0,0 +1,132 @@
+#pragma once
+
+#include <algorithm>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "detail/Cursor.h"
+#include "detail/PrefetchCursor.h"
+#include "detail/PreparedStatement.h"
+#include "detail/Statement.h"
+#include "detail/TupleUtils.h"
+
+namespace BrilliantDB
+{
+	template<class T>
+	struct is_get_statement : std::false_type {};
+
+	template<class T, class... Ts>
+	struct is_get_statement<GetStatement<T, Ts...>> : std::true_type {};
+
+	template<class T>
+	constexpr std::size_t ParamSlots()
+	{
+		if constexpr (is_param<T>::value) { return T::index + 1; }
+		else { return 0; }
+	}
+
+	template<class... Is>
+	constexpr std::size_t ParamCount(std::type_identity<std::tuple<Is...>>)
+	{
+		return std::max({ std::size_t{ 0 }, ParamSlots<Is>()... });
+	}
+
+	//arguments Run, Stream and Prefetch take, the highest Param index of the statement plus one
+	template<class S>
+	inline constexpr std::size_t iParamCount = ParamCount(std::type_identity<decltype(TupleUtils::Flatten(TupleUtils::BuildFromOther(Extractor(), std::declval<const S&>().tItems)))>{});
+
+	//a statement prepared once, Param placeholders are rebound on every Run or Stream
+	template<class D, class S>
+	struct Query
+	{
+		Query(const D& d, const S& statement) : db(d), stmt(Prepare(statement, d))
+		{
+			int iIndex = 1;
+			auto tExtracted = TupleUtils::Flatten(TupleUtils::BuildFromOther(Extractor(), statement.tItems));
+			TupleUtils::for_each_tuple(tExtracted, [&](const auto& item) {
+				using ItemType = std::decay_t<decltype(item)>;
+				if constexpr (is_param<ItemType>::value)
+				{
+					vSlots.emplace_back(iIndex, ItemType::index);
+				}
+				if constexpr (is_in_statement<ItemType>::value) { iIndex += static_cast<int>(item.vValues.size()); }
+				else { iIndex++; }
+				});
+		}
+
+		~Query()
+		{
+			sqlite3_finalize(stmt.pStmt);
+		}
+
+		Query(const Query& other) = delete;
+		Query(Query&& other) noexcept : db(other.db), stmt(other.stmt), vSlots(std::move(other.vSlots))
+		{
+			other.stmt.pStmt = nullptr;
+		}
+
+		Query& operator= (const Query& other) = delete;
+		Query& operator= (Query&& other) = delete;
+
+		//returns the rows for a select, otherwise the number of rows changed
+		template<class... As>
+		auto Run(As&&... args) noexcept(false)
+		{
+			Rebind(std::forward<As>(args)...);
+			if constexpr (is_get_statement<S>::value)
+			{
+				return db.template Materialize<typename S::TableType>(stmt);
+			}
+			else
+			{
+				while (db.Execute(stmt));
+				db.template ClearCache<typename S::TableType>();
+				return sqlite3_changes(db.connection.pDb);
+			}
+		}
+
+		//the cursor borrows the statement, it must not outlive the query or be used after the next Run
+		template<class... As> requires is_get_statement<S>::value
+		Cursor<D, S> Stream(As&&... args) noexcept(false)
+		{
+			Rebind(std::forward<As>(args)...);
+			return { db, stmt, false };
+		}
+
+		//same borrowing rules as Stream, rows are built up to iCapacity ahead of the caller on a background thread
+		template<class... As> requires is_get_statement<S>::value
+		PrefetchCursor<D, S> Prefetch(std::size_t iCapacity, As&&... args) noexcept(false)
+		{
+			Rebind(std::forward<As>(args)...);
+			return { db, stmt, false, iCapacity };
+		}
+
+		const D& db;
+		PreparedStatement<S> stmt;
+		std::vector<std::pair<int, std::size_t>> vSlots; //bind index, Param index
+
+	private:
+		template<class... As>
+		void Rebind(As&&... args)
+		{
+			static_assert(sizeof...(As) == iParamCount<S>, "pass one argument per Param of the statement");
+			sqlite3_reset(stmt.pStmt);
+			std::size_t iArg = 0;
+			(BindArg(iArg++, args), ...);
+		}
+
+		template<class A>
+		void BindArg(std::size_t iArg, const A& a)
+		{
+			Binder binder{ db.connection, stmt };
+			for (auto& [iIndex, iParam] : vSlots)
+			{
+				if (iParam == iArg)
+				{
+					binder.iIndex = iIndex;
+					binder(a);
+				}
+			}
+		}
+	};
+}
\ No newline at end of file
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "detail/ObjectCache.h"
+
+namespace BrilliantDB
+{
+	struct ResultCacheOptions
+	{
+		std::size_t iBudget = 16 * 1024 * 1024; //approximate bytes of cached rows
+		std::chrono::milliseconds ttl{ 0 }; //0 keeps entries until invalidated or evicted, set it when other connections write
+	};
+
+	//materialized select results keyed by their expanded sql
+	//a write bumps its table's generation, entries from an older generation are dropped when next looked up or evicted
+	//single threaded like ObjectCache
+	struct ResultCache
+	{
+		using clock = std::chrono::steady_clock;
+
+		explicit ResultCache(const ResultCacheOptions& o) : options(o) {}
+
+		template<class T>
+		std::shared_ptr<const std::vector<T>> Find(const std::string& sKey)
+		{
+			auto it = mIndex.find(sKey);
+			if (it == mIndex.end())
+			{
+				stats.iMisses++;
+				return nullptr;
+			}
+			auto& entry = *it->second;
+			if (entry.iGeneration != Generation(entry.sTable) || (options.ttl.count() && clock::now() - entry.tStored > options.ttl))
+			{
+				Erase(it);
+				stats.iMisses++;
+				return nullptr;
+			}
+			stats.iHits++;
+			lEntries.splice(lEntries.begin(), lEntries, it->second);
+			return std::static_pointer_cast<const std::vector<T>>(entry.pRows);
+		}
+
+		template<class T>
+		void Put(const std::string& sKey, const std::string& sTable, std::vector<T> vRows, std::size_t iBytes)
+		{
+			if (iBytes > options.iBudget) { return; }
+			if (auto it = mIndex.find(sKey); it != mIndex.end()) { Erase(it); }
+			lEntries.push_front({ sKey, sTable, Generation(sTable), clock::now(), iBytes, std::make_shared<const std::vector<T>>(std::move(vRows)) });
+			mIndex.emplace(sKey, lEntries.begin());
+			iUsed += iBytes;
+			while (iUsed > options.iBudget)
+			{
+				Erase(mIndex.find(lEntries.back().sKey));
+				stats.iEvictions++;
+			}
+		}
+
+		void Invalidate(const std::string& sTable)
+		{
+			mGenerations[sTable]++;
+		}
+
+		void Clear()
+		{
+			lEntries.clear();
+			mIndex.clear();
+			iUsed = 0;
+		}
+
+		std::size_t Used() const { return iUsed; }
+
+		ResultCacheOptions options;
+		CacheStats stats;
+
+	private:
+		struct Entry
+		{
+			std::string sKey;
+			std::string sTable;
+			std::uint64_t iGeneration;
+			clock::time_point tStored;
+			std::size_t iBytes;
+			std::shared_ptr<const void> pRows;
+		};
+
+		std::uint64_t Generation(const std::string& sTable) const
+		{
+			auto it = mGenerations.find(sTable);
+			return it == mGenerations.end() ? 0 : it->second;
+		}
+
+		void Erase(typename std::unordered_map<std::string, typename std::list<Entry>::iterator>::iterator it)
+		{
+			iUsed -= it->second->iBytes;
+			lEntries.erase(it->second);
+			mIndex.erase(it);
+		}
+
+		std::size_t iUsed = 0;
+		std::list<Entry> lEntries;
+		std::unordered_map<std::string, typename std::list<Entry>::iterator> mIndex;
+		std::unordered_map<std::string, std::uint64_t> mGenerations;
+	};
+}
\ No newline at end of file
@@ -1,15 +1,24 @@
 #pragma once
 
+#include <cstring>
+#include <memory>
+#include <memory_resource>
 #include <optional>
+#include <stdexcept>
 #include <string>
+#include <type_traits>
 #include <vector>
 
+#include "detail/ColumnTraits.h"
 #include "detail/GeneralConcepts.h"
 #include "detail/KeyTypes.h"
 #include "detail/PreparedStatement.h"
 
 namespace BrilliantDB
 {
+	template<class T>
+	concept PmrColumnType = std::same_as<T, std::pmr::string> || std::same_as<T, std::pmr::vector<char>>;
+
 	struct RowExtractor
 	{
 		template<RelativelyLargeInt T, class S>
@@ -60,18 +69,89 @@ namespace BrilliantDB
 			return {};
 		}
 
+		template<class T, class S> requires is_compressed<std::decay_t<T>>::value
+		std::decay_t<T> Extract(const PreparedStatement<S>& stmt)
+		{
+			std::decay_t<T> ret;
+			auto buffer = static_cast<const char*>(sqlite3_column_blob(stmt.pStmt, iIndex));
+			std::size_t sz = sqlite3_column_bytes(stmt.pStmt, iIndex);
+			iIndex++;
+			ret.Decode(buffer, sz);
+			return ret;
+		}
+
+		template<CustomColumnType T, class S>
+		T Extract(const PreparedStatement<S>& stmt)
+		{
+			using StorageType = typename ColumnTraits<T>::StorageType;
+			return ColumnTraits<T>::FromStorage(Extract<StorageType>(stmt));
+		}
+
+		//copies the blob straight into the destination member, NULL value initializes it and a blob of any other size throws
+		template<RawBlobType T, class S>
+		void ExtractTo(T& dest, const PreparedStatement<S>& stmt)
+		{
+			if (sqlite3_column_type(stmt.pStmt, iIndex) == SQLITE_NULL)
+			{
+				iIndex++;
+				dest = T{};
+				return;
+			}
+			auto buffer = sqlite3_column_blob(stmt.pStmt, iIndex);
+			std::size_t sz = sqlite3_column_bytes(stmt.pStmt, iIndex);
+			iIndex++;
+			if (sz != sizeof(T))
+			{
+				throw std::runtime_error("raw blob column holds " + std::to_string(sz) + " bytes but the member is " + std::to_string(sizeof(T)));
+			}
+			std::memcpy(&dest, buffer, sizeof(T));
+		}
+
+		//builds the value on pResource in a temporary, so a throwing allocation leaves the member untouched
+		//pmr allocators don't propagate on assignment, a member on another resource is moved into instead, which can't throw
+		template<PmrColumnType T, class S>
+		void ExtractTo(T& dest, const PreparedStatement<S>& stmt)
+		{
+			const char* buffer = nullptr;
+			if constexpr (std::same_as<T, std::pmr::string>) { buffer = reinterpret_cast<const char*>(sqlite3_column_text(stmt.pStmt, iIndex)); }
+			else { buffer = static_cast<const char*>(sqlite3_column_blob(stmt.pStmt, iIndex)); }
+			std::size_t sz = sqlite3_column_bytes(stmt.pStmt, iIndex);
+			iIndex++;
+			T value(pResource);
+			if (buffer) { value.assign(buffer, buffer + sz); }
+			if (dest.get_allocator() == value.get_allocator())
+			{
+				dest = std::move(value);
+				return;
+			}
+			static_assert(std::is_nothrow_move_constructible_v<T>);
+			std::destroy_at(&dest);
+			std::construct_at(&dest, std::move(value));
+		}
+
 		int iIndex = 0;
+		std::pmr::memory_resource* pResource = std::pmr::get_default_resource();
 	};
 
+	//std::pmr::string and std::pmr::vector<char> members are allocated from pResource
 	template<class T, class... Ts, class S>
-	std::optional<T> Build(const PreparedStatement<S>& stmt, const std::tuple<Ts...>& cols)
+	std::optional<T> Build(const PreparedStatement<S>& stmt, const std::tuple<Ts...>& cols, std::pmr::memory_resource* pResource = std::pmr::get_default_resource())
 	{
 		RowExtractor extractor;
+		extractor.pResource = pResource;
 		auto obj = std::make_optional<T>();
 		TupleUtils::for_each_tuple(cols, [&](auto& col) 
 			requires !is_foreign_key<T>::value 
 			{
-			(*obj).*col.pMember = extractor.Extract<typename std::decay_t<decltype(col)>::FieldType>(stmt);
+			using FieldType = typename std::decay_t<decltype(col)>::FieldType;
+			if constexpr (RawBlobType<FieldType> || PmrColumnType<FieldType>)
+			{
+				extractor.ExtractTo((*obj).*col.pMember, stmt);
+			}
+			else
+			{
+				(*obj).*col.pMember = extractor.Extract<FieldType>(stmt);
+			}
 			});
 		return obj;
 	}
@@ -0,0 +1,148 @@
+#pragma once
+
+//requires sqlite built with SQLITE_ENABLE_SESSION and SQLITE_ENABLE_PREUPDATE_HOOK, defined for the whole project
+#if defined(SQLITE_ENABLE_SESSION) && defined(SQLITE_ENABLE_PREUPDATE_HOOK)
+
+#include <fstream>
+#include <istream>
+#include <iterator>
+#include <ostream>
+#include <string>
+#include <vector>
+#include <sqlite3.h>
+#include "detail/SqliteError.h"
+
+namespace BrilliantDB
+{
+	//what to do with a change that conflicts with the target database, see sqlite3changeset_apply
+	enum class ConflictPolicy
+	{
+		omit,
+		replace,
+		abort
+	};
+
+	//serialized changeset or patchset as produced by the session extension
+	struct Changeset
+	{
+		void Write(std::ostream& os) const
+		{
+			os.write(vData.data(), vData.size());
+		}
+
+		static Changeset Read(std::istream& is)
+		{
+			return { { std::istreambuf_iterator<char>(is), std::istreambuf_iterator<char>() } };
+		}
+
+		void Save(const std::string& sFile) const
+		{
+			std::ofstream os(sFile, std::ios::binary);
+			Write(os);
+		}
+
+		static Changeset Load(const std::string& sFile)
+		{
+			std::ifstream is(sFile, std::ios::binary);
+			return Read(is);
+		}
+
+		bool Empty() const { return vData.empty(); }
+
+		std::vector<char> vData;
+	};
+
+	//records changes made through its connection to the attached tables
+	struct Session
+	{
+		explicit Session(sqlite3* db) noexcept(false) : pDb(db)
+		{
+			if (sqlite3session_create(pDb, "main", &pSession) != SQLITE_OK)
+			{
+				ThrowError(pDb);
+			}
+		}
+
+		~Session()
+		{
+			if (pSession) { sqlite3session_delete(pSession); }
+		}
+
+		Session(const Session& other) = delete;
+		Session(Session&& other) noexcept : pDb(other.pDb), pSession(other.pSession)
+		{
+			other.pSession = nullptr;
+		}
+
+		Session& operator= (const Session& other) = delete;
+		Session& operator= (Session&& other) = delete;
+
+		//an empty name attaches every table
+		void Attach(const std::string& sTable) noexcept(false)
+		{
+			if (sqlite3session_attach(pSession, sTable.empty() ? nullptr : sTable.c_str()) != SQLITE_OK)
+			{
+				ThrowError(pDb);
+			}
+		}
+
+		Changeset GetChangeset() const noexcept(false)
+		{
+			return Collect(&sqlite3session_changeset);
+		}
+
+		//smaller than a changeset since it omits original values, but can't detect every conflict
+		Changeset GetPatchset() const noexcept(false)
+		{
+			return Collect(&sqlite3session_patchset);
+		}
+
+		bool Empty() const { return sqlite3session_isempty(pSession); }
+
+		sqlite3* pDb;
+		sqlite3_session* pSession = nullptr;
+
+	private:
+		Changeset Collect(int (*f)(sqlite3_session*, int*, void**)) const
+		{
+			int iSize = 0;
+			void* pData = nullptr;
+			int rc = f(pSession, &iSize, &pData);
+			if (rc != SQLITE_OK)
+			{
+				throw std::system_error(rc, SqliteCategory(), "collecting the changeset failed");
+			}
+			Changeset ret;
+			ret.vData.assign(static_cast<const char*>(pData), static_cast<const char*>(pData) + iSize);
+			sqlite3_free(pData);
+			return ret;
+		}
+	};
+
+	inline void ApplyChangeset(sqlite3* pDb, const Changeset& changes, ConflictPolicy policy) noexcept(false)
+	{
+		auto conflict = [](void* pCtx, int eConflict, sqlite3_changeset_iter*) -> int {
+			switch (*static_cast<ConflictPolicy*>(pCtx))
+			{
+			case ConflictPolicy::replace:
+				//replace is only valid for data and constraint conflicts
+				if (eConflict == SQLITE_CHANGESET_DATA || eConflict == SQLITE_CHANGESET_CONFLICT) { return SQLITE_CHANGESET_REPLACE; }
+				return SQLITE_CHANGESET_OMIT;
+			case ConflictPolicy::abort:
+				return SQLITE_CHANGESET_ABORT;
+			default:
+				return SQLITE_CHANGESET_OMIT;
+			}
+		};
+
+		//the result isn't left in sqlite3_errcode, an abort from the conflict handler reports SQLITE_ABORT only here
+		int rc = sqlite3changeset_apply(pDb, static_cast<int>(changes.vData.size()), const_cast<char*>(changes.vData.data()),
+			nullptr, conflict, &policy);
+		if (rc != SQLITE_OK)
+		{
+			throw std::system_error(rc, SqliteCategory(), "applying the changeset failed");
+		}
+	}
+}
+
+#endif
\ No newline at end of file
@@ -19,8 +19,15 @@ namespace BrilliantDB
 		}
 	};
 
+	//error_code keeps a pointer to its category, so a temporary would dangle once the exception leaves the throw
+	inline const SqliteErrorCat& SqliteCategory()
+	{
+		static const SqliteErrorCat cat;
+		return cat;
+	}
+
 	inline void ThrowError(sqlite3* pDb)
 	{
-		throw std::system_error(sqlite3_errcode(pDb), SqliteErrorCat()), sqlite3_errmsg(pDb);
+		throw std::system_error(sqlite3_errcode(pDb), SqliteCategory(), sqlite3_errmsg(pDb));
 	}
 }
\ No newline at end of file
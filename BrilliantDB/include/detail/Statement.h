@@ -1,6 +1,12 @@
 #pragma once
 
 #include <concepts>
+#include <cstddef>
+#include <initializer_list>
+#include <ranges>
+#include <string>
+#include <tuple>
+#include <vector>
 #include "detail/KeyTypes.h"
 
 namespace BrilliantDB
@@ -72,6 +78,19 @@ namespace BrilliantDB
 		return { std::forward_as_tuple(args...) };
 	}
 
+	//matches the primary key columns of T, which may be a composite key, against the given values in order
+	template<class T, class... Ks>
+	struct KeyWhereStatement
+	{
+		std::tuple<Ks...> tKeys;
+	};
+
+	template<class T, class... Ks>
+	[[nodiscard]] KeyWhereStatement<T, std::decay_t<Ks>...> WhereKey(Ks&&... keys)
+	{
+		return { std::make_tuple(std::forward<Ks>(keys)...) };
+	}
+
 	template<class T, class... Ts>
 	struct DeleteStatement : Statement<Ts...>
 	{
@@ -120,6 +139,116 @@ namespace BrilliantDB
 		return os;
 	}
 
+	//placeholder for a value supplied when a Query is run, N is the index of the Run argument
+	template<std::size_t N>
+	struct Param_t {};
+
+	template<std::size_t N>
+	inline constexpr Param_t<N> Param{};
+
+	//column comparison against a Param, bound on each Query::Run rather than at prepare time
+	template<class T, class U, std::size_t N>
+	struct PC
+	{
+		using TableType = T;
+		using FieldType = U;
+		static constexpr std::size_t index = N;
+
+		PC(U T::* p, comparator c) : pMember(p), comp(c) {}
+
+		PC operator! () const
+		{
+			auto ret = *this;
+			ret.bNot = !bNot;
+			return ret;
+		}
+
+		bool bNot = false;
+		U T::* pMember;
+		comparator comp;
+	};
+
+	//col IN (?, ...), one placeholder per value
+	template<class T, class U>
+	struct InC
+	{
+		using TableType = T;
+		using FieldType = U;
+
+		InC operator! () const
+		{
+			auto ret = *this;
+			ret.bNot = !bNot;
+			return ret;
+		}
+
+		bool bNot = false;
+		U T::* pMember;
+		std::vector<U> vValues;
+	};
+
+	template<class T, class U>
+	struct BetweenC
+	{
+		using TableType = T;
+		using FieldType = U;
+
+		BetweenC operator! () const
+		{
+			auto ret = *this;
+			ret.bNot = !bNot;
+			return ret;
+		}
+
+		bool bNot = false;
+		U T::* pMember;
+		U low;
+		U high;
+	};
+
+	enum class pattern_op
+	{
+		like,
+		glob
+	};
+
+	//LIKE is case insensitive for ascii, GLOB is case sensitive and uses unix wildcards
+	template<class T, class U>
+	struct PatternC
+	{
+		using TableType = T;
+		using FieldType = U;
+
+		PatternC operator! () const
+		{
+			auto ret = *this;
+			ret.bNot = !bNot;
+			return ret;
+		}
+
+		bool bNot = false;
+		U T::* pMember;
+		pattern_op op;
+		std::string value;
+	};
+
+	template<class T, class U>
+	struct NullC
+	{
+		using TableType = T;
+		using FieldType = U;
+
+		NullC operator! () const
+		{
+			auto ret = *this;
+			ret.bNot = !bNot;
+			return ret;
+		}
+
+		bool bNot = false;
+		U T::* pMember;
+	};
+
 	template<class T, class U>
 	struct C
 	{
@@ -176,6 +305,21 @@ namespace BrilliantDB
 			return *this;
 		}
 
+		template<std::size_t N> PC<T, U, N> operator== (Param_t<N>) const { return { pMember, comparator::equal }; }
+		template<std::size_t N> PC<T, U, N> operator< (Param_t<N>) const { return { pMember, comparator::less }; }
+		template<std::size_t N> PC<T, U, N> operator<= (Param_t<N>) const { return { pMember, comparator::less_eq }; }
+		template<std::size_t N> PC<T, U, N> operator> (Param_t<N>) const { return { pMember, comparator::great }; }
+		template<std::size_t N> PC<T, U, N> operator>= (Param_t<N>) const { return { pMember, comparator::great_eq }; }
+		template<std::size_t N> PC<T, U, N> operator!= (Param_t<N>) const { return { pMember, comparator::not_equal }; }
+
+		template<std::ranges::input_range R>
+		[[nodiscard]] InC<T, U> In(const R& values) const { return { false, pMember, std::vector<U>(std::ranges::begin(values), std::ranges::end(values)) }; }
+		[[nodiscard]] InC<T, U> In(std::initializer_list<U> values) const { return { false, pMember, std::vector<U>(values) }; }
+		[[nodiscard]] BetweenC<T, U> Between(const U& low, const U& high) const { return { false, pMember, low, high }; }
+		[[nodiscard]] PatternC<T, U> Like(std::string pattern) const { return { false, pMember, pattern_op::like, std::move(pattern) }; }
+		[[nodiscard]] PatternC<T, U> Glob(std::string pattern) const { return { false, pMember, pattern_op::glob, std::move(pattern) }; }
+		[[nodiscard]] NullC<T, U> IsNull() const { return { false, pMember }; }
+
 		bool bNot = false;
 		comparator comp = comparator::equal;
 		U T::* pMember;
@@ -188,6 +332,130 @@ namespace BrilliantDB
 	template<class T, class U>
 	struct is_col_statement<C<T, U>> : std::true_type {};
 
+	template<class T, class U, std::size_t N>
+	struct is_col_statement<PC<T, U, N>> : std::true_type {};
+
+	template<class T, class U>
+	struct is_col_statement<InC<T, U>> : std::true_type {};
+
+	template<class T, class U>
+	struct is_col_statement<BetweenC<T, U>> : std::true_type {};
+
+	template<class T, class U>
+	struct is_col_statement<PatternC<T, U>> : std::true_type {};
+
+	template<class T, class U>
+	struct is_col_statement<NullC<T, U>> : std::true_type {};
+
+	//call to a function registered with Database::RegisterFunction, member pointers are passed as columns
+	template<class... As>
+	struct FunctionCall
+	{
+		FunctionCall(std::string name, As... args) : sName(std::move(name)), tArgs(std::move(args)...) {}
+
+		FunctionCall operator! () const
+		{
+			auto ret = *this;
+			ret.bNot = !bNot;
+			return ret;
+		}
+
+		bool bNot = false;
+		std::string sName;
+		std::tuple<As...> tArgs;
+	};
+
+	template<class... As>
+	[[nodiscard]] FunctionCall<std::decay_t<As>...> Call(std::string name, As&&... args)
+	{
+		return { std::move(name), std::forward<As>(args)... };
+	}
+
+	//comparison of a function result against a value, e.g. Call("score", &T::s) > 0.5
+	template<class F, class V>
+	struct FunctionCompare
+	{
+		F call;
+		comparator comp;
+		V value;
+	};
+
+	template<class... As, class V>
+	FunctionCompare<FunctionCall<As...>, V> operator== (const FunctionCall<As...>& f, const V& v) { return { f, comparator::equal, v }; }
+
+	template<class... As, class V>
+	FunctionCompare<FunctionCall<As...>, V> operator< (const FunctionCall<As...>& f, const V& v) { return { f, comparator::less, v }; }
+
+	template<class... As, class V>
+	FunctionCompare<FunctionCall<As...>, V> operator<= (const FunctionCall<As...>& f, const V& v) { return { f, comparator::less_eq, v }; }
+
+	template<class... As, class V>
+	FunctionCompare<FunctionCall<As...>, V> operator> (const FunctionCall<As...>& f, const V& v) { return { f, comparator::great, v }; }
+
+	template<class... As, class V>
+	FunctionCompare<FunctionCall<As...>, V> operator>= (const FunctionCall<As...>& f, const V& v) { return { f, comparator::great_eq, v }; }
+
+	template<class... As, class V>
+	FunctionCompare<FunctionCall<As...>, V> operator!= (const FunctionCall<As...>& f, const V& v) { return { f, comparator::not_equal, v }; }
+
+	template<class... As>
+	struct is_col_statement<FunctionCall<As...>> : std::true_type {};
+
+	template<class F, class V>
+	struct is_col_statement<FunctionCompare<F, V>> : std::true_type {};
+
+	//full-text match of a column against an fts5 query, requires a MakeFtsTable index over T
+	template<class T, class U>
+	struct MatchC
+	{
+		using TableType = T;
+		using FieldType = U;
+
+		U T::* pMember;
+		std::string value;
+	};
+
+	template<class T, class U>
+	[[nodiscard]] MatchC<T, U> Match(U T::* p, std::string query)
+	{
+		return { p, std::move(query) };
+	}
+
+	template<class T, class U>
+	struct is_col_statement<MatchC<T, U>> : std::true_type {};
+
+	//joins the full-text index once and orders by its rank, best first, so only rows the match finds are returned
+	//has to be the last item of the select
+	template<class T, class U>
+	struct OrderByRankStatement
+	{
+		MatchC<T, U> match;
+	};
+
+	template<class T, class U>
+	[[nodiscard]] OrderByRankStatement<T, U> OrderByRank(const MatchC<T, U>& m)
+	{
+		return { m };
+	}
+
+	template<class T>
+	struct is_order_by_rank : std::false_type {};
+
+	template<class T, class U>
+	struct is_order_by_rank<OrderByRankStatement<T, U>> : std::true_type {};
+
+	template<class T>
+	struct is_param : std::false_type {};
+
+	template<class T, class U, std::size_t N>
+	struct is_param<PC<T, U, N>> : std::true_type {};
+
+	template<class T>
+	struct is_in_statement : std::false_type {};
+
+	template<class T, class U>
+	struct is_in_statement<InC<T, U>> : std::true_type {};
+
 	template<class T>
 	concept ColStatement = is_col_statement<std::decay_t<T>>::value;
 
@@ -197,10 +465,20 @@ namespace BrilliantDB
 		_or
 	};
 
+	//operands are held by value so nested groups stay valid, the printer parenthesizes every group
 	template<ColStatement T, ColStatement U, logical_c V>
 	struct LogicalC
 	{
 		LogicalC(T c1, U c2) : t(std::make_tuple(std::move(c1), std::move(c2))) {}
+
+		LogicalC operator! () const
+		{
+			auto ret = *this;
+			ret.bNot = !bNot;
+			return ret;
+		}
+
+		bool bNot = false;
 		std::tuple<T, U> t;
 	};
 
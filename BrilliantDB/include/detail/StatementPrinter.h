@@ -1,13 +1,16 @@
 #pragma once
 
+#include <stdexcept>
 #include <string>
 #include <sstream>
 #include <type_traits>
+#include <sqlite3.h>
 
 #include "detail/Statement.h"
 #include "detail/TypePrinter.h"
 #include "detail/TupleUtils.h"
 #include "detail/Table.h"
+#include "detail/FtsTable.h"
 #include "detail/Column.h"
 
 namespace BrilliantDB
@@ -27,10 +30,15 @@ namespace BrilliantDB
 			ss << "'" << statement.sName << "' " << TypePrinter<F>::Print() << ' ';
 			for (const auto& c : statement.vConstraints)
 			{
-				ss << c << ' ';
+				if (c != Constraint::primary_key || bInlinePrimaryKey)
+				{
+					ss << c << ' ';
+				}
 			}
 			return ss.str();
 		}
+
+		bool bInlinePrimaryKey = true; //false when the table declares a composite key instead
 	};
 
 	template<class O1,class F1, class O2, class F2>
@@ -57,18 +65,82 @@ namespace BrilliantDB
 		template<class C>
 		std::string operator() (const statement_type& statement, const C& context)
 		{
+			const bool bCompositeKey = statement.vPrimaryKeys.size() > 1;
 			std::stringstream ss;
 			ss << "CREATE TABLE IF NOT EXISTS '" << statement.sName << "' ( ";
 			std::size_t i = 0;
 			TupleUtils::for_each_tuple(statement.tCols, [&](auto& col) {
-				ss << Print(col, context);
+				using ColType = std::decay_t<decltype(col)>;
+				if constexpr (is_foreign_key<ColType>::value)
+				{
+					ss << Print(col, context);
+				}
+				else
+				{
+					ss << StatementPrinter<ColType>{ !bCompositeKey }(col, context);
+				}
 				if (i < (std::tuple_size<std::tuple<Cs...>>::value - 1))
 				{
 					ss << ", ";
 				}
 				i++;
 				});
-			ss << ");";
+			if (bCompositeKey)
+			{
+				ss << ", PRIMARY KEY (";
+				for (std::size_t k = 0; k < statement.vPrimaryKeys.size(); k++)
+				{
+					ss << (k ? ", '" : "'") << statement.vPrimaryKeys[k] << '\'';
+				}
+				ss << ')';
+			}
+			ss << ")";
+			if (statement.HasOption(TableOption::without_rowid))
+			{
+				ss << " WITHOUT ROWID";
+			}
+			if (statement.HasOption(TableOption::strict))
+			{
+				if (sqlite3_libversion_number() < iStrictMinVersion)
+				{
+					throw std::runtime_error("table '" + statement.sName + "' is STRICT, which needs SQLite 3.37.0 or later but " + sqlite3_libversion() + " is linked");
+				}
+				ss << (statement.HasOption(TableOption::without_rowid) ? ", STRICT" : " STRICT");
+			}
+			ss << ";";
+			return ss.str();
+		}
+	};
+
+	template<class T, class... Ms>
+	struct StatementPrinter<FtsTable<T, Ms...>>
+	{
+		using statement_type = FtsTable<T, Ms...>;
+
+		template<class C>
+		std::string operator() (const statement_type& statement, const C& context)
+		{
+			const std::string& sFts = statement.sName;
+			const std::string sContent = context.template GetTableName<T>();
+			const std::string sKey = context.GetColumnName(context.template GetTable<T>().template GetColumn<primary_key_t>().pMember);
+
+			std::string sCols, sNew, sOld;
+			TupleUtils::for_each_tuple(statement.tCols, [&](auto& p) {
+				const std::string sCol = context.GetColumnName(p);
+				sCols += ", \"" + sCol + "\"";
+				sNew += ", new.\"" + sCol + "\"";
+				sOld += ", old.\"" + sCol + "\"";
+				});
+
+			const std::string sInsert = "INSERT INTO \"" + sFts + "\"(rowid" + sCols + ") VALUES (new.\"" + sKey + "\"" + sNew + ");";
+			const std::string sDelete = "INSERT INTO \"" + sFts + "\"(\"" + sFts + "\", rowid" + sCols + ") VALUES ('delete', old.\"" + sKey + "\"" + sOld + ");";
+
+			std::stringstream ss;
+			ss << "CREATE VIRTUAL TABLE IF NOT EXISTS \"" << sFts << "\" USING fts5(" << sCols.substr(2)
+				<< ", content='" << sContent << "', content_rowid='" << sKey << "');"
+				<< "CREATE TRIGGER IF NOT EXISTS \"" << sFts << "_ai\" AFTER INSERT ON \"" << sContent << "\" BEGIN " << sInsert << " END;"
+				<< "CREATE TRIGGER IF NOT EXISTS \"" << sFts << "_ad\" AFTER DELETE ON \"" << sContent << "\" BEGIN " << sDelete << " END;"
+				<< "CREATE TRIGGER IF NOT EXISTS \"" << sFts << "_au\" AFTER UPDATE ON \"" << sContent << "\" BEGIN " << sDelete << ' ' << sInsert << " END;";
 			return ss.str();
 		}
 	};
@@ -84,20 +156,20 @@ namespace BrilliantDB
 			auto& table = context.template GetTable<T>();
 			std::string sInsert = "INSERT INTO '" + table.sName + "' (";
 			std::string sValues = "Values (";
-			std::size_t i = 0;
+			bool bFirst = true;
 			TupleUtils::for_each_tuple(table.tCols, [&](auto& col) {
-				if (!is_foreign_key<std::decay_t<decltype(col)>>::value && 
-					std::find(col.vConstraints.cbegin(), col.vConstraints.cend(), Constraint::primary_key) == col.vConstraints.cend())
+				//same columns as the values built by Database::Insert, rowid keys are assigned by sqlite
+				if (!is_foreign_key<std::decay_t<decltype(col)>>::value && !is_primary_key<std::decay_t<decltype(col)>>::value)
 				{
-					sInsert += "\"" + col.sName + "\"";
-					sValues += "?";
-					if (i < std::tuple_size<decltype(table.tCols)>::value - table.iNumForeignKeys - 1)
+					if (!bFirst)
 					{
 						sInsert += ", ";
 						sValues += ", ";
 					}
+					sInsert += "\"" + col.sName + "\"";
+					sValues += "?";
+					bFirst = false;
 				}
-				i++;
 				});
 			sInsert += ") ";
 			sValues += ')';
@@ -116,7 +188,18 @@ namespace BrilliantDB
 			auto& table = context.template GetTable<T>();
 			std::stringstream ss;
 
-			ss << "SELECT * FROM '" << table.sName << '\'';
+			constexpr std::size_t iRanked = (std::size_t{ is_order_by_rank<std::decay_t<Ts>>::value } + ... + 0);
+			if constexpr (iRanked)
+			{
+				//the other items filter the content table in a subquery, so their columns can't clash with the index's
+				static_assert(iRanked == 1 && is_order_by_rank<std::decay_t<std::tuple_element_t<sizeof...(Ts) - 1, std::tuple<Ts...>>>>::value,
+					"OrderByRank has to be the last item of a select");
+				ss << "SELECT \"" << table.sName << "\".* FROM (SELECT * FROM '" << table.sName << '\'';
+			}
+			else
+			{
+				ss << "SELECT * FROM '" << table.sName << '\'';
+			}
 			TupleUtils::for_each_tuple(statement.tItems, [&](auto& item) {
 				ss << Print(item, context);
 				});
@@ -211,6 +294,25 @@ namespace BrilliantDB
 		}
 	};
 
+	template<class T, class... Ks>
+	struct StatementPrinter<KeyWhereStatement<T, Ks...>>
+	{
+		using statement_type = KeyWhereStatement<T, Ks...>;
+
+		template<class C>
+		std::string operator() (const statement_type& statement, const C& context)
+		{
+			std::stringstream ss;
+			ss << " WHERE ";
+			const auto& vKeys = context.template GetTable<T>().vPrimaryKeys;
+			for (std::size_t i = 0; i < vKeys.size(); i++)
+			{
+				ss << (i ? " AND \"" : "\"") << vKeys[i] << "\"=?";
+			}
+			return ss.str();
+		}
+	};
+
 	template<class T, class U>
 	struct StatementPrinter<C<T, U>>
 	{
@@ -225,6 +327,160 @@ namespace BrilliantDB
 		}
 	};
 
+	template<class T, class U, std::size_t N>
+	struct StatementPrinter<PC<T, U, N>>
+	{
+		using statement_type = PC<T, U, N>;
+
+		template<class C>
+		std::string operator() (const statement_type& statement, const C& context)
+		{
+			std::stringstream ss;
+			ss << (statement.bNot ? " NOT " : "") << context.GetColumnName(statement.pMember) << statement.comp << "?";
+			return ss.str();
+		}
+	};
+
+	template<class T, class U>
+	struct StatementPrinter<InC<T, U>>
+	{
+		using statement_type = InC<T, U>;
+
+		template<class C>
+		std::string operator() (const statement_type& statement, const C& context)
+		{
+			std::stringstream ss;
+			ss << (statement.bNot ? " NOT " : "") << context.GetColumnName(statement.pMember) << " IN (";
+			for (std::size_t i = 0; i < statement.vValues.size(); i++)
+			{
+				ss << (i ? ", ?" : "?");
+			}
+			ss << ')';
+			return ss.str();
+		}
+	};
+
+	template<class T, class U>
+	struct StatementPrinter<BetweenC<T, U>>
+	{
+		using statement_type = BetweenC<T, U>;
+
+		template<class C>
+		std::string operator() (const statement_type& statement, const C& context)
+		{
+			std::stringstream ss;
+			ss << (statement.bNot ? " NOT " : "") << '(' << context.GetColumnName(statement.pMember) << " BETWEEN ? AND ?)";
+			return ss.str();
+		}
+	};
+
+	template<class T, class U>
+	struct StatementPrinter<PatternC<T, U>>
+	{
+		using statement_type = PatternC<T, U>;
+
+		template<class C>
+		std::string operator() (const statement_type& statement, const C& context)
+		{
+			std::stringstream ss;
+			ss << (statement.bNot ? " NOT " : "") << context.GetColumnName(statement.pMember) << (statement.op == pattern_op::like ? " LIKE ?" : " GLOB ?");
+			return ss.str();
+		}
+	};
+
+	template<class T, class U>
+	struct StatementPrinter<NullC<T, U>>
+	{
+		using statement_type = NullC<T, U>;
+
+		template<class C>
+		std::string operator() (const statement_type& statement, const C& context)
+		{
+			std::stringstream ss;
+			ss << context.GetColumnName(statement.pMember) << (statement.bNot ? " IS NOT NULL" : " IS NULL");
+			return ss.str();
+		}
+	};
+
+	template<class... As>
+	struct StatementPrinter<FunctionCall<As...>>
+	{
+		using statement_type = FunctionCall<As...>;
+
+		template<class C>
+		std::string operator() (const statement_type& statement, const C& context)
+		{
+			std::stringstream ss;
+			ss << (statement.bNot ? " NOT " : "") << statement.sName << '(';
+			std::size_t i = 0;
+			TupleUtils::for_each_tuple(statement.tArgs, [&](auto& arg) {
+				if constexpr (std::is_member_object_pointer_v<std::decay_t<decltype(arg)>>)
+				{
+					ss << context.GetColumnName(arg);
+				}
+				else
+				{
+					ss << '?';
+				}
+				if (i < sizeof...(As) - 1)
+				{
+					ss << ", ";
+				}
+				i++;
+				});
+			ss << ')';
+			return ss.str();
+		}
+	};
+
+	template<class F, class V>
+	struct StatementPrinter<FunctionCompare<F, V>>
+	{
+		using statement_type = FunctionCompare<F, V>;
+
+		template<class C>
+		std::string operator() (const statement_type& statement, const C& context)
+		{
+			std::stringstream ss;
+			ss << Print(statement.call, context) << statement.comp << "?";
+			return ss.str();
+		}
+	};
+
+	template<class T, class U>
+	struct StatementPrinter<MatchC<T, U>>
+	{
+		using statement_type = MatchC<T, U>;
+
+		template<class C>
+		std::string operator() (const statement_type& statement, const C& context)
+		{
+			std::stringstream ss;
+			ss << '"' << context.GetColumnName(context.template GetTable<T>().template GetColumn<primary_key_t>().pMember)
+				<< "\" IN (SELECT rowid FROM \"" << context.template GetTable<Fts<T>>().sName
+				<< "\" WHERE \"" << context.GetColumnName(statement.pMember) << "\" MATCH ?)";
+			return ss.str();
+		}
+	};
+
+	template<class T, class U>
+	struct StatementPrinter<OrderByRankStatement<T, U>>
+	{
+		using statement_type = OrderByRankStatement<T, U>;
+
+		template<class C>
+		std::string operator() (const statement_type& statement, const C& context)
+		{
+			const std::string sFts = context.template GetTable<Fts<T>>().sName;
+			const std::string sContent = context.template GetTableName<T>();
+			std::stringstream ss;
+			ss << ") AS \"" << sContent << "\" JOIN \"" << sFts << "\" ON \"" << sFts << "\".rowid = \"" << sContent << "\".\""
+				<< context.GetColumnName(context.template GetTable<T>().template GetColumn<primary_key_t>().pMember)
+				<< "\" WHERE \"" << sFts << "\".\"" << context.GetColumnName(statement.match.pMember) << "\" MATCH ? ORDER BY \"" << sFts << "\".rank";
+			return ss.str();
+		}
+	};
+
 	template<class T, class U>
 	struct StatementPrinter<LogicalC<T, U, logical_c::_and>>
 	{
@@ -234,7 +490,7 @@ namespace BrilliantDB
 		std::string operator() (const statement_type& statement, const C& context)
 		{
 			std::stringstream ss;
-			ss << Print(std::get<0>(statement.t), context) << " AND " << Print(std::get<1>(statement.t), context);
+			ss << (statement.bNot ? " NOT " : "") << '(' << Print(std::get<0>(statement.t), context) << " AND " << Print(std::get<1>(statement.t), context) << ')';
 			return ss.str();
 		}
 	};
@@ -248,7 +504,7 @@ namespace BrilliantDB
 		std::string operator() (const statement_type& statement, const C& context)
 		{
 			std::stringstream ss;
-			ss << Print(std::get<0>(statement.t), context) << " OR " << Print(std::get<1>(statement.t), context);
+			ss << (statement.bNot ? " NOT " : "") << '(' << Print(std::get<0>(statement.t), context) << " OR " << Print(std::get<1>(statement.t), context) << ')';
 			return ss.str();
 		}
 	};
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <algorithm>
 #include <compare>
 #include <string>
 #include <sstream>
@@ -27,16 +28,34 @@ namespace BrilliantDB
 		return lh.iColId < rh.iColId;
 	}
 
+	enum class TableOption
+	{
+		without_rowid,
+		strict //needs SQLite 3.37.0 or later, creating the table throws on an older library
+	};
+
+	inline constexpr int iStrictMinVersion = 3037000;
+
 	template<class P, class... Cs>
 		struct Table
 	{
-		Table(std::string name, std::tuple<Cs...> t) : iNumForeignKeys(0), sName(std::move(name)), tCols(std::move(t))
+		Table(std::string name, std::tuple<Cs...> t, std::vector<TableOption> options = {}) : iNumForeignKeys(0), sName(std::move(name)), tCols(std::move(t)),
+			vOptions(std::move(options))
 		{
 			TupleUtils::for_each_tuple(tCols, [&](auto& col) {
 				if (is_foreign_key<std::decay_t<decltype(col)>>::value) { iNumForeignKeys++; }
+				else if (std::find(col.vConstraints.cbegin(), col.vConstraints.cend(), Constraint::primary_key) != col.vConstraints.cend())
+				{
+					vPrimaryKeys.push_back(col.sName);
+				}
 				});
 		}
 
+		bool HasOption(TableOption o) const
+		{
+			return std::find(vOptions.cbegin(), vOptions.cend(), o) != vOptions.cend();
+		}
+
 		template<class C> 
 		auto GetColumn() const
 		{
@@ -69,7 +88,20 @@ namespace BrilliantDB
 		std::size_t iNumForeignKeys;
 		std::string sName;
 		std::tuple<Cs...> tCols;
+		std::vector<TableOption> vOptions;
+		std::vector<std::string> vPrimaryKeys; //more than one is a composite key
+
+		//whether the key is a primary_key_t rowid alias rather than natural key columns
+		static constexpr bool bHasRowidKey = (is_primary_key<Cs>::value || ...);
 
 		using PrimaryType = P;
 	};
+
+	//binds the key columns of an object, in declaration order, for tables with natural keys
+	template<class T, class Tbl>
+	struct ObjectKey
+	{
+		const T& obj;
+		const Tbl& table;
+	};
 }
\ No newline at end of file
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <functional>
+#include <sqlite3.h>
+#include "detail/Connection.h"
+#include "detail/SqliteError.h"
+
+namespace BrilliantDB
+{
+	//immediate takes the write lock up front, a deferred transaction that reads and then writes can fail with SQLITE_BUSY
+	//when another writer holds the lock, without the busy handler being called
+	enum class TransactionMode
+	{
+		deferred,
+		immediate,
+		exclusive
+	};
+
+	//RAII transaction, rolls back on destruction unless Commit was called
+	struct Transaction
+	{
+		explicit Transaction(const Connection& c, std::function<void()> committed = {}, TransactionMode mode = TransactionMode::deferred) noexcept(false) :
+			conn(c), onCommit(std::move(committed))
+		{
+			const char* sBegin = mode == TransactionMode::immediate ? "BEGIN IMMEDIATE" : mode == TransactionMode::exclusive ? "BEGIN EXCLUSIVE" : "BEGIN";
+			if (sqlite3_exec(conn.pDb, sBegin, nullptr, nullptr, nullptr) != SQLITE_OK)
+			{
+				ThrowError(conn.pDb);
+			}
+		}
+
+		~Transaction()
+		{
+			if (!bDone)
+			{
+				sqlite3_exec(conn.pDb, "ROLLBACK", nullptr, nullptr, nullptr);
+			}
+		}
+
+		Transaction(const Transaction& other) = delete;
+		Transaction& operator= (const Transaction& other) = delete;
+
+		void Commit() noexcept(false)
+		{
+			if (sqlite3_exec(conn.pDb, "COMMIT", nullptr, nullptr, nullptr) != SQLITE_OK)
+			{
+				ThrowError(conn.pDb);
+			}
+			bDone = true;
+			if (onCommit) { onCommit(); }
+		}
+
+		bool bDone = false;
+		const Connection& conn;
+		std::function<void()> onCommit;
+	};
+}
\ No newline at end of file
@@ -0,0 +1,303 @@
+#pragma once
+
+#include <algorithm>
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <sqlite3.h>
+
+namespace BrilliantDB
+{
+	enum class TransferFormat
+	{
+		csv,
+		binary
+	};
+
+	//rows are moved as raw column values so stored encodings (compressed, custom types) round trip untouched
+	//header line of column names, text is always quoted, NULL is an empty field and blobs are written as X'hex'
+	struct CsvFormat
+	{
+		static void WriteHeader(std::ostream& os, const std::vector<std::string>& vNames)
+		{
+			for (std::size_t i = 0; i < vNames.size(); i++)
+			{
+				if (i) { os.put(','); }
+				WriteQuoted(os, vNames[i].data(), vNames[i].size());
+			}
+			os.put('\n');
+		}
+
+		static void WriteRow(std::ostream& os, sqlite3_stmt* pStmt)
+		{
+			const int iCols = sqlite3_column_count(pStmt);
+			for (int i = 0; i < iCols; i++)
+			{
+				if (i) { os.put(','); }
+				switch (sqlite3_column_type(pStmt, i))
+				{
+				case SQLITE_INTEGER:
+					os << sqlite3_column_int64(pStmt, i);
+					break;
+				case SQLITE_FLOAT:
+				{
+					char buffer[32];
+					auto res = std::to_chars(buffer, buffer + sizeof(buffer), sqlite3_column_double(pStmt, i));
+					os.write(buffer, res.ptr - buffer);
+					if (std::find_if(buffer, res.ptr, [](char c) { return c == '.' || c == 'e' || c == 'n'; }) == res.ptr) { os << ".0"; } //keep it a real on import
+					break;
+				}
+				case SQLITE_TEXT:
+					WriteQuoted(os, reinterpret_cast<const char*>(sqlite3_column_text(pStmt, i)), sqlite3_column_bytes(pStmt, i));
+					break;
+				case SQLITE_BLOB:
+				{
+					static constexpr char sHex[] = "0123456789abcdef";
+					auto p = static_cast<const unsigned char*>(sqlite3_column_blob(pStmt, i));
+					const int n = sqlite3_column_bytes(pStmt, i);
+					os << "X'";
+					for (int k = 0; k < n; k++) { os.put(sHex[p[k] >> 4]).put(sHex[p[k] & 0xf]); }
+					os.put('\'');
+					break;
+				}
+				default:
+					break;
+				}
+			}
+			os.put('\n');
+		}
+
+		static void WriteEnd(std::ostream&) {}
+
+		static std::vector<std::string> ReadHeader(std::istream& is)
+		{
+			std::vector<Field> vFields;
+			if (!ReadRecord(is, vFields)) { throw std::runtime_error("missing csv header"); }
+			std::vector<std::string> vNames;
+			for (auto& field : vFields) { vNames.push_back(std::move(field.sText)); }
+			return vNames;
+		}
+
+		//binds the next record to pStmt, returns false at the end of the input
+		static bool ReadRow(std::istream& is, sqlite3_stmt* pStmt, std::size_t iCols)
+		{
+			thread_local std::vector<Field> vFields;
+			if (!ReadRecord(is, vFields)) { return false; }
+			if (vFields.size() != iCols) { throw std::runtime_error("csv record has the wrong number of fields"); }
+			for (std::size_t i = 0; i < iCols; i++)
+			{
+				if (BindField(pStmt, static_cast<int>(i) + 1, vFields[i]) != SQLITE_OK) { throw std::runtime_error("failed to bind csv field"); }
+			}
+			return true;
+		}
+
+	private:
+		struct Field
+		{
+			std::string sText;
+			bool bQuoted = false;
+		};
+
+		static void WriteQuoted(std::ostream& os, const char* p, std::size_t n)
+		{
+			os.put('"');
+			for (std::size_t i = 0; i < n; i++)
+			{
+				if (p[i] == '"') { os.put('"'); }
+				os.put(p[i]);
+			}
+			os.put('"');
+		}
+
+		static bool ReadRecord(std::istream& is, std::vector<Field>& vFields)
+		{
+			auto pBuf = is.rdbuf();
+			if (pBuf->sgetc() == std::char_traits<char>::eof()) { return false; }
+			vFields.assign(1, {});
+			bool bInQuotes = false;
+			for (int c = pBuf->sbumpc(); c != std::char_traits<char>::eof(); c = pBuf->sbumpc())
+			{
+				auto& field = vFields.back();
+				if (bInQuotes)
+				{
+					if (c != '"') { field.sText.push_back(static_cast<char>(c)); }
+					else if (pBuf->sgetc() == '"') { field.sText.push_back(static_cast<char>(pBuf->sbumpc())); }
+					else { bInQuotes = false; }
+				}
+				else if (c == '"' && field.sText.empty()) { bInQuotes = field.bQuoted = true; }
+				else if (c == ',') { vFields.emplace_back(); }
+				else if (c == '\n') { return true; }
+				else if (c != '\r') { field.sText.push_back(static_cast<char>(c)); }
+			}
+			if (bInQuotes) { throw std::runtime_error("unterminated quoted csv field"); }
+			return true;
+		}
+
+		static int Hex(char c)
+		{
+			if (c >= '0' && c <= '9') { return c - '0'; }
+			if (c >= 'a' && c <= 'f') { return c - 'a' + 10; }
+			if (c >= 'A' && c <= 'F') { return c - 'A' + 10; }
+			throw std::runtime_error("bad hex digit in csv blob");
+		}
+
+		static int BindField(sqlite3_stmt* pStmt, int iIndex, const Field& field)
+		{
+			const auto& s = field.sText;
+			if (field.bQuoted) { return sqlite3_bind_text(pStmt, iIndex, s.data(), static_cast<int>(s.size()), SQLITE_TRANSIENT); }
+			if (s.empty()) { return sqlite3_bind_null(pStmt, iIndex); }
+			if (s.size() >= 3 && (s[0] == 'X' || s[0] == 'x') && s[1] == '\'' && s.back() == '\'')
+			{
+				std::vector<char> vBlob((s.size() - 3) / 2);
+				for (std::size_t k = 0; k < vBlob.size(); k++) { vBlob[k] = static_cast<char>(Hex(s[2 + 2 * k]) << 4 | Hex(s[3 + 2 * k])); }
+				return sqlite3_bind_blob64(pStmt, iIndex, vBlob.data(), vBlob.size(), SQLITE_TRANSIENT);
+			}
+			const char* pEnd = s.data() + s.size();
+			sqlite3_int64 iValue = 0;
+			if (auto res = std::from_chars(s.data(), pEnd, iValue); res.ec == std::errc() && res.ptr == pEnd) { return sqlite3_bind_int64(pStmt, iIndex, iValue); }
+			double dValue = 0;
+			if (auto res = std::from_chars(s.data(), pEnd, dValue); res.ec == std::errc() && res.ptr == pEnd) { return sqlite3_bind_double(pStmt, iIndex, dValue); }
+			return sqlite3_bind_text(pStmt, iIndex, s.data(), static_cast<int>(s.size()), SQLITE_TRANSIENT);
+		}
+	};
+
+	//"BDBT", column count and names, then per row a 1 byte marker followed by a type tag and payload per value, a 0 marker ends the stream
+	//integers are little endian, text and blobs are prefixed with their 8 byte length
+	struct BinaryFormat
+	{
+		static void WriteHeader(std::ostream& os, const std::vector<std::string>& vNames)
+		{
+			os.write(sMagic, sizeof(sMagic));
+			PutU64(os, vNames.size());
+			for (const auto& sName : vNames) { PutBytes(os, sName.data(), sName.size()); }
+		}
+
+		static void WriteRow(std::ostream& os, sqlite3_stmt* pStmt)
+		{
+			os.put(1);
+			const int iCols = sqlite3_column_count(pStmt);
+			for (int i = 0; i < iCols; i++)
+			{
+				const int iType = sqlite3_column_type(pStmt, i);
+				os.put(static_cast<char>(iType));
+				switch (iType)
+				{
+				case SQLITE_INTEGER:
+					PutU64(os, static_cast<std::uint64_t>(sqlite3_column_int64(pStmt, i)));
+					break;
+				case SQLITE_FLOAT:
+				{
+					double d = sqlite3_column_double(pStmt, i);
+					std::uint64_t u;
+					std::memcpy(&u, &d, sizeof(u));
+					PutU64(os, u);
+					break;
+				}
+				case SQLITE_TEXT:
+					PutBytes(os, reinterpret_cast<const char*>(sqlite3_column_text(pStmt, i)), sqlite3_column_bytes(pStmt, i));
+					break;
+				case SQLITE_BLOB:
+					PutBytes(os, static_cast<const char*>(sqlite3_column_blob(pStmt, i)), sqlite3_column_bytes(pStmt, i));
+					break;
+				default:
+					break;
+				}
+			}
+		}
+
+		static void WriteEnd(std::ostream& os) { os.put(0); }
+
+		static std::vector<std::string> ReadHeader(std::istream& is)
+		{
+			char magic[sizeof(sMagic)];
+			if (!is.read(magic, sizeof(magic)) || std::memcmp(magic, sMagic, sizeof(sMagic))) { throw std::runtime_error("not a binary table export"); }
+			std::vector<std::string> vNames(GetU64(is));
+			std::vector<char> vBuffer;
+			for (auto& sName : vNames)
+			{
+				GetBytes(is, vBuffer);
+				sName.assign(vBuffer.begin(), vBuffer.end());
+			}
+			return vNames;
+		}
+
+		static bool ReadRow(std::istream& is, sqlite3_stmt* pStmt, std::size_t iCols)
+		{
+			int iMarker = is.get();
+			if (iMarker == 0 || iMarker == std::char_traits<char>::eof()) { return false; }
+			if (iMarker != 1) { throw std::runtime_error("corrupt binary table export"); }
+
+			thread_local std::vector<char> vBuffer;
+			for (std::size_t i = 0; i < iCols; i++)
+			{
+				const int iIndex = static_cast<int>(i) + 1;
+				int rc = SQLITE_OK;
+				switch (is.get())
+				{
+				case SQLITE_INTEGER:
+					rc = sqlite3_bind_int64(pStmt, iIndex, static_cast<sqlite3_int64>(GetU64(is)));
+					break;
+				case SQLITE_FLOAT:
+				{
+					std::uint64_t u = GetU64(is);
+					double d;
+					std::memcpy(&d, &u, sizeof(d));
+					rc = sqlite3_bind_double(pStmt, iIndex, d);
+					break;
+				}
+				case SQLITE_TEXT:
+					GetBytes(is, vBuffer);
+					rc = sqlite3_bind_text64(pStmt, iIndex, vBuffer.data(), vBuffer.size(), SQLITE_TRANSIENT, SQLITE_UTF8);
+					break;
+				case SQLITE_BLOB:
+					GetBytes(is, vBuffer);
+					rc = sqlite3_bind_blob64(pStmt, iIndex, vBuffer.data(), vBuffer.size(), SQLITE_TRANSIENT);
+					break;
+				case SQLITE_NULL:
+					rc = sqlite3_bind_null(pStmt, iIndex);
+					break;
+				default:
+					throw std::runtime_error("corrupt binary table export");
+				}
+				if (rc != SQLITE_OK) { throw std::runtime_error("failed to bind binary field"); }
+			}
+			return true;
+		}
+
+	private:
+		static constexpr char sMagic[4] = { 'B', 'D', 'B', 'T' };
+
+		static void PutU64(std::ostream& os, std::uint64_t n)
+		{
+			char buffer[8];
+			for (int i = 0; i < 8; i++) { buffer[i] = static_cast<char>((n >> (8 * i)) & 0xff); }
+			os.write(buffer, sizeof(buffer));
+		}
+
+		static std::uint64_t GetU64(std::istream& is)
+		{
+			unsigned char buffer[8];
+			if (!is.read(reinterpret_cast<char*>(buffer), sizeof(buffer))) { throw std::runtime_error("truncated binary table export"); }
+			std::uint64_t n = 0;
+			for (int i = 0; i < 8; i++) { n |= static_cast<std::uint64_t>(buffer[i]) << (8 * i); }
+			return n;
+		}
+
+		static void PutBytes(std::ostream& os, const char* p, std::size_t n)
+		{
+			PutU64(os, n);
+			if (n) { os.write(p, n); }
+		}
+
+		static void GetBytes(std::istream& is, std::vector<char>& vOut)
+		{
+			vOut.resize(GetU64(is));
+			if (!vOut.empty() && !is.read(vOut.data(), vOut.size())) { throw std::runtime_error("truncated binary table export"); }
+		}
+	};
+}
\ No newline at end of file
@@ -1,7 +1,11 @@
 #pragma once
 
+#include <array>
 #include <concepts>
+#include <cstddef>
 #include <tuple>
+#include <type_traits>
+#include <utility>
 
 namespace TupleUtils
 {
@@ -14,57 +18,32 @@ namespace TupleUtils
 	template<class L, class T>
 	concept BuilderCallable = requires (L l, T t) { l(t); };
 
-	template<class L>
-	class TupleBuilder
+	//positions of the elements l can be called with, worked out in one constexpr pass instead of one instantiation per element
+	template<class L, class... Ts>
+	constexpr auto CallableIndices()
 	{
-	public:
-		TupleBuilder(const L& l) : _l(l) {}
-
-		template<class... Ts>
-		constexpr auto operator() (Ts&&... args) const
-		{
-			std::tuple<> t;
-			return Build(t, std::forward<Ts>(args)...);
-		}
-
-	private:
-		constexpr auto Build(const std::tuple<>& tpl) const
-		{
-			return tpl;
-		}
-
-		template<class... Us, class T, class... Ts>
-		constexpr auto Build(const std::tuple<Us...>& tpl, T&& t, Ts&&... args) const requires BuilderCallable<L, T>
-		{
-			auto _tpl = std::tuple_cat(tpl, std::make_tuple(_l(std::forward<T>(t))));
-			return Build(_tpl, std::forward<Ts>(args)...);
-		}
-
-		template<class... Us, class T, class... Ts>
-		constexpr auto Build(const std::tuple<Us...>& tpl, T&& t, Ts&&... args) const requires !BuilderCallable<L, T>
-		{
-			return Build(tpl, std::forward<Ts>(args)...);
-		}
-
-		template<class... Us, class T>
-		constexpr auto Build(const std::tuple<Us...>& tpl, T&& t) const requires BuilderCallable<L, T>
-		{
-			return std::tuple_cat(tpl, std::make_tuple(_l(std::forward<T>(t))));
-		}
-
-		template<class... Us, class T>
-		constexpr auto Build(const std::tuple<Us...>& tpl, const T& t) const requires !BuilderCallable<L, T>
+		constexpr bool bCallable[] = { BuilderCallable<L, const Ts&>..., false };
+		std::array<std::size_t, (std::size_t(0) + ... + std::size_t(BuilderCallable<L, const Ts&>))> a{};
+		std::size_t j = 0;
+		for (std::size_t i = 0; i < sizeof...(Ts); i++)
 		{
-			return tpl;
+			if (bCallable[i]) { a[j++] = i; }
 		}
+		return a;
+	}
 
-		L _l;
-	};
+	template<class L, class... Ts, std::size_t... Is>
+	constexpr auto BuildFromOther(const L& l, const std::tuple<Ts...>& t, std::index_sequence<Is...>)
+	{
+		[[maybe_unused]] constexpr auto a = CallableIndices<L, Ts...>(); //unused when l accepts none of the items
+		return std::tuple<std::decay_t<decltype(l(std::get<a[Is]>(t)))>...>{ l(std::get<a[Is]>(t))... }; //braces keep the calls in order
+	}
 
+	//tuple of l(item) for every item l accepts, items it can't be called with are skipped
 	template<class L, class... Ts>
-	auto BuildFromOther(const L& l, const std::tuple<Ts...>& t)
+	constexpr auto BuildFromOther(const L& l, const std::tuple<Ts...>& t)
 	{
-		return std::apply(TupleBuilder(l), t);
+		return BuildFromOther(l, t, std::make_index_sequence<CallableIndices<L, Ts...>().size()>());
 	}
 
 	template<class T>
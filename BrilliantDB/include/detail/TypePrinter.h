@@ -1,7 +1,10 @@
 #pragma once
 
+#include <memory_resource>
 #include <string>
 #include "detail/KeyTypes.h"
+#include "detail/Compressed.h"
+#include "detail/ColumnTraits.h"
 
 namespace BrilliantDB
 {
@@ -56,6 +59,9 @@ namespace BrilliantDB
 	template<>
 	struct TypePrinter<std::string> : public TextPrinter {};
 
+	template<>
+	struct TypePrinter<std::pmr::string> : public TextPrinter {};
+
 	template<>
 	struct TypePrinter<std::wstring> : public TextPrinter {};
 
@@ -70,4 +76,16 @@ namespace BrilliantDB
 
 	template<>
 	struct TypePrinter<std::vector<char>> : public BlobPrinter {};
+
+	template<>
+	struct TypePrinter<std::pmr::vector<char>> : public BlobPrinter {};
+
+	template<class T, class Codec, std::size_t N>
+	struct TypePrinter<Compressed<T, Codec, N>> : public BlobPrinter {};
+
+	template<RawBlobType T>
+	struct TypePrinter<T> : public BlobPrinter {};
+
+	template<CustomColumnType T>
+	struct TypePrinter<T> : public TypePrinter<typename ColumnTraits<T>::StorageType> {};
 }
\ No newline at end of file